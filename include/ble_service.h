@@ -8,7 +8,9 @@
 #ifndef BLE_SERVICE_H
 #define BLE_SERVICE_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include "symptom_stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +43,21 @@ void ble_update(int state,
                 int dyskinesia_flag,
                 int fog_flag);
 
+/*
+ * 更新长期统计 characteristic（每结束一分钟调用一次）：
+ *   0xA014: HourSummary[STATS_HOURS]
+ *   0xA015: MinuteSummary[STATS_MINUTES]
+ * 环形存储，顺序不保证，手机按 start_ts / minute_id 排序
+ *
+ * 时间戳来自设备 RTC，同时刷新 0xA016（设备当前时间，uint32 UNIX 秒）。
+ * RTC 上电从 0 开始，手机写 0xA016 即调用 set_time() 校准；校准前的
+ * 统计用 "手机时间 - 设备时间" 的差值换算。
+ */
+void ble_update_summary(const MinuteSummary *minutes, const HourSummary *hours);
+
+// characteristic 值缓冲区占用的静态 RAM（不含 BLE 协议栈本身）
+size_t ble_ram_bytes(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <arm_math.h>
+#include "fft_analysis.h"
+#include "zoom_fft.h"
+
+/*
+Window classifier over spectral band features.
+
+Band energies are turned into an int8 feature vector and run through one
+small decision tree per label. Trees are complete binary trees of fixed
+depth stored as arrays, so every call does exactly CLS_TREE_DEPTH
+comparisons per label: constant time, no heap, model in flash.
+Models are generated by tools/train_classifier.py into classifier_model.h.
+*/
+
+// analysis bands (Hz)
+#define CLS_TREM_LOW    2.0f
+#define CLS_TREM_HIGH   3.0f
+#define CLS_DYSK_LOW    4.0f
+#define CLS_DYSK_HIGH   5.0f
+#define CLS_STEP_LOW    3.0f
+#define CLS_STEP_HIGH   5.0f
+#define CLS_TOTAL_LOW   0.5f
+#define CLS_TOTAL_HIGH  10.0f
+
+// feature vector: band ratios scaled by 100, variance scaled by 1000, clamped to 127
+#define CLS_FEAT_TREM       0
+#define CLS_FEAT_DYSK       1
+#define CLS_FEAT_STEP       2
+#define CLS_FEAT_VAR        3
+#define CLS_NUM_FEATURES    4
+#define CLS_RATIO_SCALE     100.0f
+#define CLS_VAR_SCALE       1000.0f
+
+// output labels, one tree each, returned as a bit mask
+#define CLS_TREMOR          0x01
+#define CLS_DYSKINESIA      0x02
+#define CLS_WALKING         0x04
+#define CLS_NUM_LABELS      3
+
+#define CLS_TREE_DEPTH      3
+#define CLS_TREE_NODES      ((1 << CLS_TREE_DEPTH) - 1)
+#define CLS_TREE_LEAVES     (1 << CLS_TREE_DEPTH)
+
+// node i goes to 2i+2 if features[feature[i]] > threshold[i], else 2i+1
+typedef struct {
+    int8_t  feature[CLS_TREE_NODES];
+    int8_t  threshold[CLS_TREE_NODES];
+    uint8_t leaf[CLS_TREE_LEAVES];
+} ClsTree;
+
+typedef struct {
+    ClsTree tree[CLS_NUM_LABELS];   // CLS_TREMOR, CLS_DYSKINESIA, CLS_WALKING
+} ClsModel;
+
+typedef struct {
+    float32_t trem;
+    float32_t dysk;
+    float32_t step;
+    float32_t total;
+} BandEnergy;
+
+void classifier_set_model(const ClsModel *model);
+void classifier_band_energy(const FftContext *ctx, BandEnergy *e);
+void classifier_band_energy_zoom(const ZoomFftContext *ctx, BandEnergy *e);
+void classifier_quantize(const BandEnergy *e, float32_t variance, int8_t *features);
+uint8_t classifier_run(const int8_t *features);
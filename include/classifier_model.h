@@ -0,0 +1,25 @@
+#pragma once
+#include "classifier.h"
+
+// Generated by tools/train_classifier.py --rules
+// Reproduces the fixed ratio thresholds: trem >= 0.10, dysk >= 0.10, step >= 0.20
+
+static const ClsModel cls_default_model = {
+    {
+        { // tremor
+            { 0, 0, 0, 0, 0, 0, 0 },
+            { 9, 127, 127, 127, 127, 127, 127 },
+            { 0, 0, 0, 0, 1, 0, 0, 0 },
+        },
+        { // dyskinesia
+            { 1, 1, 1, 1, 1, 1, 1 },
+            { 9, 127, 127, 127, 127, 127, 127 },
+            { 0, 0, 0, 0, 1, 0, 0, 0 },
+        },
+        { // walking
+            { 2, 2, 2, 2, 2, 2, 2 },
+            { 19, 127, 127, 127, 127, 127, 127 },
+            { 0, 0, 0, 0, 1, 0, 0, 0 },
+        },
+    }
+};
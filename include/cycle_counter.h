@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+
+/*
+DWT cycle counter of the Cortex-M4, for measuring per-stage cost.
+On host builds (no CMSIS core) it reads as zero.
+*/
+
+#if defined(__arm__)
+#include "cmsis.h"
+
+static inline void cycle_counter_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t cycle_counter_read(void)
+{
+    return DWT->CYCCNT;
+}
+#else
+static inline void cycle_counter_init(void) {}
+static inline uint32_t cycle_counter_read(void) { return 0; }
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#include <arm_math.h>
+#include "imu_driver.h"
+#include "fft_analysis.h"
+#include "zoom_fft.h"
+#include "classifier.h"
+#include "filter.h"
+#include "orientation.h"
+
+/*
+Per-window detection pipeline, shared by main.cpp and the host tools.
+Gravity is removed from every sample by the orientation filter and the
+linear acceleration is fused with the gyro into one signed signal (each
+projected on its dominant axis, so oscillations keep their frequency);
+every WINDOW_SAMPLES a window goes through the stationary check, FFT
+band energies, the
+classifier and the FOG state machine. With USE_ZOOM_FFT the band energies
+and the peak come from the zoom FFT instead of the full-band FFT.
+
+All per-stream state lives in a Detector, so several streams can be
+analysed side by side (see tools/gateway.cpp). The only shared memory is
+the scratch arena, which is per thread on host builds.
+*/
+
+#define WINDOW_SEC      3           // 3s for window
+#define WINDOW_SAMPLES  (SAMPLE_RATE * WINDOW_SEC) // 156点，需<=FFT_SIZE
+#define FUSION_ALPHA    0.7f        // 0.7 表示加速度计占主导
+
+// 1: spectrum from zoom_fft (0.1 Hz bins around 0.5-10 Hz), 0: full-band FFT_SIZE FFT.
+// The default model was trained on full-band energies.
+#ifndef USE_ZOOM_FFT
+#define USE_ZOOM_FFT    0
+#endif
+
+typedef struct {
+    OrientationState orient;
+    LowpassState lowpass;
+    DominantAxisState accel_axis;
+    DominantAxisState gyro_axis;
+#if USE_ZOOM_FFT
+    ZoomFftContext fft;
+#else
+    FftContext fft;
+#endif
+    float32_t window[WINDOW_SAMPLES];   // fused samples of the current window
+    int sample_idx;
+    int stationary_windows;   // count of consecutive no-step windows
+    bool had_steps;           // steps seen since the last FOG
+    uint32_t orient_cycles_sum;   // orientation cost over the current window
+    uint32_t orient_cycles_max;
+} Detector;
+
+typedef struct {
+    int state;                // 0=Normal, 1=Tremor, 2=Dyskinesia, 3=FOG
+    int tremor_flag;
+    int dyskinesia_flag;
+    int fog_flag;
+    bool stationary;
+    bool walking;
+    float32_t variance;
+    BandEnergy energy;        // all zero when the FFT was skipped
+    SpectralPeak peak;        // dominant frequency in CLS_TOTAL_LOW..HIGH, interpolated
+    uint32_t classifier_cycles;
+    uint32_t orientation_cycles_mean;   // per sample, 0 on host builds
+    uint32_t orientation_cycles_max;
+} WindowResult;
+
+void detector_init(Detector *d);
+float32_t detector_fuse(Detector *d, AccelData accel, GyroData gyro);
+bool detector_push(Detector *d, AccelData accel, GyroData gyro, WindowResult *r);
+void detector_process_window(Detector *d, const float32_t *window,
+                             int length, WindowResult *r);
+uint8_t detector_flags(const WindowResult *r);
@@ -0,0 +1,12 @@
+#pragma once
+
+/*
+Storage class for the scratch arena. Host tools (-DHOST_BUILD) run
+detectors on several threads, so there each thread gets its own arena;
+on the device it is plain static.
+*/
+#ifdef HOST_BUILD
+#define DSP_STATE static thread_local
+#else
+#define DSP_STATE static
+#endif
@@ -3,10 +3,31 @@
 
 #define SAMPLE_RATE   52       // sample rate (Hz)
 #define FFT_SIZE      256      // 2^N points FFT
+#define FFT_BINS      (FFT_SIZE / 2)   // bins up to Nyquist
 
-bool fft_compute(const float32_t *input, int length);
-float32_t fft_get_band_max(float32_t f_low, float32_t f_high);
-bool detect_tremor(void);
-bool detect_dyskinesia(void);
+// magnitude spectrum of the last fft_compute(), one per detector instance
+typedef struct {
+    float32_t mag[FFT_BINS];
+} FftContext;
+
+// interpolated spectral peak
+typedef struct {
+    float32_t freq;   // Hz
+    float32_t amp;
+} SpectralPeak;
+
+bool fft_compute(FftContext *ctx, const float32_t *input, int length);
+float32_t fft_get_band_max(const FftContext *ctx, float32_t f_low, float32_t f_high);
+SpectralPeak fft_get_peak(const FftContext *ctx, float32_t f_low, float32_t f_high);
+SpectralPeak spectral_peak_interp(const float32_t *mag, int start_bin, int end_bin,
+                                  float32_t f0, float32_t bin_hz);
+/*
+Variance threshold for "not moving", in units of the fused signal (the
+gyro term, in dps, sets its scale). Rest with 0.004 g / 0.3 dps sensor
+noise gives 0.006-0.010, the weakest synthetic tremor (0.03 g) about 0.65.
+*/
+#define STATIONARY_VAR  0.05f
+
+float32_t signal_variance(const float32_t *buf, int length);
 bool is_stationary(const float32_t *buf, int length);
-float32_t fft_get_band_energy(float32_t f_low, float32_t f_high);
+float32_t fft_get_band_energy(const FftContext *ctx, float32_t f_low, float32_t f_high);
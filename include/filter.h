@@ -1,6 +1,31 @@
 #pragma once
 #include "imu_driver.h"
 
-AccelData filter_accel_moving_average(AccelData in);
+#define FILTER_LEN 8
 
-AccelData filter_accel_lowpass(AccelData in);
+// filter state is owned by the caller, one per signal
+typedef struct {
+    float ax_buf[FILTER_LEN];
+    float ay_buf[FILTER_LEN];
+    float az_buf[FILTER_LEN];
+    int idx;
+} MovingAverageState;
+
+typedef struct {
+    AccelData filtered;
+} LowpassState;
+
+// running second moments of a 3-axis signal and their principal axis
+typedef struct {
+    float xx, yy, zz, xy, xz, yz;
+    float axis[3];
+} DominantAxisState;
+
+void filter_moving_average_init(MovingAverageState *st);
+AccelData filter_accel_moving_average(MovingAverageState *st, AccelData in);
+
+void filter_lowpass_init(LowpassState *st);
+AccelData filter_accel_lowpass(LowpassState *st, AccelData in);
+
+void filter_dominant_axis_init(DominantAxisState *st);
+float filter_dominant_axis_project(DominantAxisState *st, float x, float y, float z);
@@ -1,8 +1,10 @@
 #pragma once
+#ifndef HOST_BUILD
 #include "stm32l4xx_hal.h"
 
 
 extern I2C_HandleTypeDef hi2c1;
+#endif
 
 #define LSM6DSL_ADDR    (0x6A << 1)   // I2C 地址
 #define WHO_AM_I_REG    0x0F
@@ -24,6 +26,7 @@ typedef struct {
     float gz;
 } GyroData;
 
+#ifndef HOST_BUILD
 // 外部 I2C 句柄：请在工程的 HW 初始化代码中初始化并配置 hi2c1
 extern I2C_HandleTypeDef hi2c1;
 
@@ -31,4 +34,5 @@ void imu_init(void);
 // 初始化 IMU 寄存器（注意：本函数不创建或配置 I2C 硬件句柄，hi2c1 必须在外部初始化）
 
 AccelData imu_read_accel(void);
-GyroData imu_read_gyro(void);
\ No newline at end of file
+GyroData imu_read_gyro(void);
+#endif
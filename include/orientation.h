@@ -0,0 +1,34 @@
+#pragma once
+#include "imu_driver.h"
+
+/*
+Orientation estimate (Madgwick IMU filter, accel + gyro) run at the full
+ODR. Used to remove gravity from the accelerometer so only linear
+acceleration reaches the analysis window: posture changes no longer leak
+1 g into the spectrum.
+
+The update has no data-dependent branches (normalisation uses a guarded
+reciprocal square root), so its cycle cost is the same for every sample.
+Initialisation from the first accel sample is a separate call.
+
+ORIENTATION_CYCLE_BUDGET is derived from the compiled update, not yet from
+a board measurement: ~140 single-precision add/sub/mul (1 cycle each on
+the M4F), 3 VSQRT + 3 VDIV (14 each), ~80 loads/stores/moves and the
+call overhead give ~320 cycles. The budget allows 2x that; main.cpp prints
+the DWT mean/max per window against it, replace the estimate with the
+measured max once known.
+*/
+
+#define ORIENTATION_BETA          0.1f    // gradient step, trades gyro drift vs accel noise
+#define ORIENTATION_CYCLE_BUDGET  640     // per sample, 2x the ~320 cycle estimate above
+
+// quaternion sensor -> earth frame
+typedef struct {
+    float q0, q1, q2, q3;
+    bool initialized;
+} OrientationState;
+
+void orientation_init(OrientationState *st);
+void orientation_init_from_accel(OrientationState *st, AccelData accel);
+AccelData orientation_update(OrientationState *st, AccelData accel, GyroData gyro, float dt);
+AccelData orientation_gravity(const OrientationState *st);
@@ -0,0 +1,39 @@
+#pragma once
+#include <arm_math.h>
+#include <stddef.h>
+#include "fft_analysis.h"
+
+/*
+Shared DSP scratch arena.
+Short-lived work buffers (FFT work area, window copies, feature vectors)
+are carved out of one static pool instead of each module keeping its own
+static array. Regions are released in LIFO order, so two regions can only
+share memory when their lifetimes do not overlap.
+*/
+
+// largest simultaneous demand: complex FFT work buffer [real, imag]
+#define SCRATCH_ARENA_FLOATS   (2 * FFT_SIZE)
+#define SCRATCH_ARENA_BYTES    (SCRATCH_ARENA_FLOATS * sizeof(float32_t))
+#define SCRATCH_MAX_REGIONS    8
+
+typedef struct {
+    int offset;          // start offset in floats, -1 when not live
+    int length;          // length in floats
+    const char *owner;   // subsystem name, used for reports
+} ScratchRegion;
+
+float32_t *scratch_acquire(ScratchRegion *region, int n_floats, const char *owner);
+void scratch_release(ScratchRegion *region);
+int scratch_high_water(void);
+int scratch_overlap_errors(void);
+
+/*
+Static RAM footprint of one subsystem. ram_report() prints the list at
+runtime together with the arena size and high-water mark.
+*/
+typedef struct {
+    const char *subsystem;
+    size_t bytes;
+} RamUsage;
+
+void ram_report(const RamUsage *usage, int count);
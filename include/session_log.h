@@ -0,0 +1,89 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "blockdevice/BlockDevice.h"
+
+/*
+Log-structured session store on the external QSPI flash.
+
+The flash is used as a ring of erase sectors. Each sector starts with a
+header (erase count, sequence number, boot number, timestamp of its first
+record) and is followed by CRC-protected records appended back to back:
+
+    | sector hdr | rec hdr | payload | rec hdr | payload | ... | 0xFF ... |
+
+Appends are O(1): the write position is kept in RAM and only the current
+sector is touched. The sector erase is not: it takes tens to hundreds of
+ms, so session_log_prepare() erases the next sector of the ring ahead of
+time, off the sampling path (main.cpp runs it on a low-priority thread).
+Preparing drops the oldest sector one sector early. Every sector is
+erased equally often.
+
+Timestamps come from the RTC, which may restart after a reboot. Each
+mount gets a boot number and writes a SESSION_REC_BOOT record with the
+RTC time it saw; if the RTC is behind the log, the whole mount is offset
+so log time keeps increasing. The first-record timestamp of every sector
+is cached in RAM, which lets range reads binary-search to the right
+sector without scanning flash.
+
+After a power loss, session_log_init() rebuilds the write position and
+discards a torn last record (CRC) or a torn sector header.
+*/
+
+#define SESSION_LOG_MAX_SECTORS   256    // 256 x 4KB = 1MB of log
+#define SESSION_LOG_MAX_PAYLOAD   512
+
+// record types
+#define SESSION_REC_WINDOW   1    // WindowRecord, one per analysis window
+#define SESSION_REC_RAW_IMU  2    // RawImuSample[], optional raw block
+#define SESSION_REC_BOOT     3    // BootRecord, first record of every mount
+
+// per-window decision and band energies
+typedef struct {
+    uint8_t state;            // 0=Normal, 1=Tremor, 2=Dyskinesia, 3=FOG
+    uint8_t flags;            // bit0 tremor, bit1 dysk, bit2 fog, bit3 stationary, bit4 walking
+    uint8_t reserved[2];
+    float trem_energy;
+    float dysk_energy;
+    float step_energy;
+    float total_energy;
+} WindowRecord;
+
+// raw IMU sample: accel in mg, gyro in 0.1 dps
+typedef struct {
+    int16_t ax, ay, az;
+    int16_t gx, gy, gz;
+} RawImuSample;
+
+// log time of the record = rtc_time + offset of this mount
+typedef struct {
+    uint32_t boot;            // increases by one per mount
+    uint32_t rtc_time;        // RTC time passed with the first append
+} BootRecord;
+
+typedef struct {
+    int sectors_used;
+    int sectors_total;
+    int head;
+    uint32_t head_offset;
+    uint32_t min_erase;       // over sectors with a readable header
+    uint32_t max_erase;
+    uint32_t boot;
+    bool next_prepared;       // next sector already erased
+    uint32_t sync_erases;     // erases that ran inside session_log_append()
+    uint32_t dropped;         // appends refused while a prepare or read held the log
+} SessionLogStats;
+
+// called for every record inside a range read; return false to stop
+typedef bool (*session_log_cb)(uint8_t type, uint32_t timestamp,
+                               const void *payload, uint16_t length, void *ctx);
+
+int session_log_init(mbed::BlockDevice *bd);
+int session_log_append(uint8_t type, uint32_t timestamp,
+                       const void *payload, uint16_t length);
+int session_log_prepare(void);
+int session_log_read_range(uint32_t t_from, uint32_t t_to,
+                           session_log_cb cb, void *ctx);
+void session_log_get_stats(SessionLogStats *st);
+void session_log_stats(void);
+size_t session_log_ram_bytes(void);   // static RAM: sector index and CRC engine
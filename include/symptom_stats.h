@@ -0,0 +1,71 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Constant-memory long-term symptom aggregation.
+
+Every analysis window is folded into a per-minute and a per-hour
+accumulator. Finished minutes and hours are kept in fixed rings in a
+compact form that is sent over BLE as is, so the phone can sync the last
+hour minute-by-minute and the last day hour-by-hour with two reads.
+
+Band ratios (trem/total, dysk/total) go into fixed 16-bin histograms.
+The bins are 0.02 wide up to 0.20, with edges on the 0.10 and 0.20
+detection thresholds, and get wider above (stats_ratio_edges).
+Percentiles are interpolated inside a bin, so their error is bounded by
+the width of the bin they fall in.
+*/
+
+#define STATS_MINUTES     60     // last hour, per minute
+#define STATS_HOURS       24     // last day, per hour
+#define STATS_RATIO_BINS  16
+
+// window flags, same bits as WindowRecord.flags
+#define STATS_TREMOR      0x01
+#define STATS_DYSKINESIA  0x02
+#define STATS_FOG         0x04
+#define STATS_STATIONARY  0x08
+#define STATS_WALKING     0x10
+
+// 8 bytes, counts saturate at 255
+typedef struct {
+    uint16_t minute_id;     // (timestamp / 60) & 0xFFFF
+    uint8_t  windows;
+    uint8_t  tremor;
+    uint8_t  dyskinesia;
+    uint8_t  fog;
+    uint8_t  walking;
+    uint8_t  trem_p50;      // median tremor ratio, 0..255 = 0..1
+} MinuteSummary;
+
+// 16 bytes, duty fractions and percentiles scaled to 0..255
+typedef struct {
+    uint32_t start_ts;      // start of the hour
+    uint16_t windows;
+    uint8_t  tremor_duty;
+    uint8_t  dysk_duty;
+    uint8_t  stationary_duty;
+    uint8_t  walking_duty;
+    uint8_t  fog_events;
+    uint8_t  trem_p50;
+    uint8_t  trem_p90;
+    uint8_t  dysk_p50;
+    uint8_t  dysk_p90;
+    uint8_t  reserved;
+} HourSummary;
+
+void symptom_stats_init(void);
+
+// returns true when the window closed a minute (rings changed)
+bool symptom_stats_add(uint32_t timestamp, uint8_t flags,
+                       float trem_ratio, float dysk_ratio);
+
+// STATS_RATIO_BINS + 1 ascending bin edges from 0 to 1
+const float *stats_ratio_edges(void);
+
+const MinuteSummary *symptom_stats_minutes(void);
+const HourSummary *symptom_stats_hours(void);
+
+// static RAM: rings plus the open minute / hour accumulators
+size_t symptom_stats_ram_bytes(void);
@@ -0,0 +1,38 @@
+#pragma once
+#include <arm_math.h>
+#include "fft_analysis.h"
+
+/*
+Zoom FFT over the 0.5-10 Hz analysis range.
+
+The window is shifted down by ZOOM_CENTER (complex demodulation), low-pass
+filtered and decimated by ZOOM_DECIM in one FIR pass, Hann windowed and
+transformed with a ZOOM_FFT_SIZE point complex FFT. At 52 Hz this gives
+~0.1 Hz bins over -1.25..11.75 Hz: half the bin width of the 256 point
+full-band FFT, for a 128 point FFT plus the FIR at a quarter of the input
+rate. The window mean is removed first, as in fft_compute(), so an offset
+does not leak into the low bins. tools/zoom_fft_bench.cpp compares both.
+
+Bin spacing is not resolution: a 3 s window still separates tones only
+~0.33 Hz apart. What improves is the peak frequency estimate, which is
+refined further by parabolic interpolation (zoom_fft_peak).
+*/
+
+#define ZOOM_DECIM       4
+#define ZOOM_RATE        ((float32_t)SAMPLE_RATE / ZOOM_DECIM)   // 13 Hz complex
+#define ZOOM_FFT_SIZE    128
+#define ZOOM_CENTER      5.25f    // Hz, middle of 0.5..10 Hz
+#define ZOOM_FIR_TAPS    32       // decimation low-pass, runs at the input rate
+#define ZOOM_FIR_CUTOFF  6.0f     // Hz, keeps 0.5-10 Hz, rejects images folded back by the decimation
+#define ZOOM_BIN_HZ      (ZOOM_RATE / ZOOM_FFT_SIZE)
+#define ZOOM_F_START     (ZOOM_CENTER - ZOOM_RATE / 2)            // frequency of mag[0]
+
+// magnitude spectrum of the last zoom_fft_compute(), mag[i] at ZOOM_F_START + i * ZOOM_BIN_HZ
+typedef struct {
+    float32_t mag[ZOOM_FFT_SIZE];
+} ZoomFftContext;
+
+bool zoom_fft_compute(ZoomFftContext *ctx, const float32_t *input, int length);
+float32_t zoom_fft_get_band_max(const ZoomFftContext *ctx, float32_t f_low, float32_t f_high);
+float32_t zoom_fft_get_band_energy(const ZoomFftContext *ctx, float32_t f_low, float32_t f_high);
+SpectralPeak zoom_fft_peak(const ZoomFftContext *ctx, float32_t f_low, float32_t f_high);
@@ -0,0 +1,68 @@
+#include "classifier.h"
+#include "classifier_model.h"
+#include "fft_analysis.h"
+
+static const ClsModel *active_model = &cls_default_model;
+
+void classifier_set_model(const ClsModel *model)
+{
+    active_model = (model != NULL) ? model : &cls_default_model;
+}
+
+// Band energies of the spectrum from the last fft_compute() on ctx
+void classifier_band_energy(const FftContext *ctx, BandEnergy *e)
+{
+    e->trem  = fft_get_band_energy(ctx, CLS_TREM_LOW, CLS_TREM_HIGH);
+    e->dysk  = fft_get_band_energy(ctx, CLS_DYSK_LOW, CLS_DYSK_HIGH);
+    e->step  = fft_get_band_energy(ctx, CLS_STEP_LOW, CLS_STEP_HIGH);
+    e->total = fft_get_band_energy(ctx, CLS_TOTAL_LOW, CLS_TOTAL_HIGH);
+}
+
+// Same bands on the zoom spectrum (~0.1 Hz bins, Hann windowed)
+void classifier_band_energy_zoom(const ZoomFftContext *ctx, BandEnergy *e)
+{
+    e->trem  = zoom_fft_get_band_energy(ctx, CLS_TREM_LOW, CLS_TREM_HIGH);
+    e->dysk  = zoom_fft_get_band_energy(ctx, CLS_DYSK_LOW, CLS_DYSK_HIGH);
+    e->step  = zoom_fft_get_band_energy(ctx, CLS_STEP_LOW, CLS_STEP_HIGH);
+    e->total = zoom_fft_get_band_energy(ctx, CLS_TOTAL_LOW, CLS_TOTAL_HIGH);
+}
+
+static int8_t quantize(float32_t x, float32_t scale)
+{
+    float32_t q = x * scale;
+    if (q <= 0.0f) return 0;
+    if (q >= 127.0f) return 127;
+    return (int8_t)q;
+}
+
+void classifier_quantize(const BandEnergy *e, float32_t variance, int8_t *features)
+{
+    float32_t inv_total = (e->total > 0.0f) ? 1.0f / e->total : 0.0f;
+
+    features[CLS_FEAT_TREM] = quantize(e->trem * inv_total, CLS_RATIO_SCALE);
+    features[CLS_FEAT_DYSK] = quantize(e->dysk * inv_total, CLS_RATIO_SCALE);
+    features[CLS_FEAT_STEP] = quantize(e->step * inv_total, CLS_RATIO_SCALE);
+    features[CLS_FEAT_VAR]  = quantize(variance, CLS_VAR_SCALE);
+}
+
+/*
+Run every label tree. No early exit, so the cost is the same for every
+input: CLS_NUM_LABELS * CLS_TREE_DEPTH compares.
+*/
+uint8_t classifier_run(const int8_t *features)
+{
+    uint8_t labels = 0;
+
+    for (int t = 0; t < CLS_NUM_LABELS; t++) {
+        const ClsTree *tree = &active_model->tree[t];
+        int node = 0;
+        for (int d = 0; d < CLS_TREE_DEPTH; d++) {
+            int go_right = features[tree->feature[node]] > tree->threshold[node];
+            node = 2 * node + 1 + go_right;
+        }
+        if (tree->leaf[node - CLS_TREE_NODES]) {
+            labels |= (uint8_t)(1 << t);
+        }
+    }
+    return labels;
+}
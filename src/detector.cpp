@@ -0,0 +1,132 @@
+#include "detector.h"
+#include "symptom_stats.h"
+#include "cycle_counter.h"
+#include <string.h>
+
+static_assert(WINDOW_SAMPLES <= FFT_SIZE, "window must fit in one FFT");
+
+/*
+Remove gravity, low-pass the linear acceleration and blend accel / gyro
+into the signal that is analysed per window. Each sensor contributes its
+signed component along its own dominant axis, not its magnitude: the
+magnitude of a zero-mean oscillation is rectified to twice its frequency
+plus DC, which moved a 2-3 Hz tremor into the dyskinesia band.
+*/
+float32_t detector_fuse(Detector *d, AccelData accel, GyroData gyro)
+{
+    if (!d->orient.initialized) {
+        orientation_init_from_accel(&d->orient, accel);
+    }
+    uint32_t t0 = cycle_counter_read();
+    accel = orientation_update(&d->orient, accel, gyro, 1.0f / SAMPLE_RATE);
+    uint32_t cycles = cycle_counter_read() - t0;
+    d->orient_cycles_sum += cycles;
+    if (cycles > d->orient_cycles_max) d->orient_cycles_max = cycles;
+
+    accel = filter_accel_lowpass(&d->lowpass, accel);
+
+    float accel_sig = filter_dominant_axis_project(&d->accel_axis, accel.ax, accel.ay, accel.az);
+    float gyro_sig  = filter_dominant_axis_project(&d->gyro_axis, gyro.gx, gyro.gy, gyro.gz);
+
+    return FUSION_ALPHA * accel_sig + (1.0f - FUSION_ALPHA) * gyro_sig;
+}
+
+void detector_init(Detector *d)
+{
+    memset(d, 0, sizeof(*d));
+    orientation_init(&d->orient);
+    filter_lowpass_init(&d->lowpass);
+    filter_dominant_axis_init(&d->accel_axis);
+    filter_dominant_axis_init(&d->gyro_axis);
+}
+
+/*
+Feed one IMU sample. Returns true and fills r when it completed a window.
+*/
+bool detector_push(Detector *d, AccelData accel, GyroData gyro, WindowResult *r)
+{
+    d->window[d->sample_idx++] = detector_fuse(d, accel, gyro);
+    if (d->sample_idx < WINDOW_SAMPLES) {
+        return false;
+    }
+
+    detector_process_window(d, d->window, WINDOW_SAMPLES, r);
+    r->orientation_cycles_mean = d->orient_cycles_sum / WINDOW_SAMPLES;
+    r->orientation_cycles_max  = d->orient_cycles_max;
+    d->orient_cycles_sum = 0;
+    d->orient_cycles_max = 0;
+    d->sample_idx = 0;
+    return true;
+}
+
+void detector_process_window(Detector *d, const float32_t *window,
+                             int length, WindowResult *r)
+{
+    memset(r, 0, sizeof(*r));
+
+    // --- Step 1: Stationary check ---
+    r->variance = signal_variance(window, length);
+    r->stationary = (r->variance < STATIONARY_VAR);
+
+    // --- Step 2: Tremor/Dyskinesia detection ---
+#if USE_ZOOM_FFT
+    if (!r->stationary && zoom_fft_compute(&d->fft, window, length)) {
+        classifier_band_energy_zoom(&d->fft, &r->energy);
+        r->peak = zoom_fft_peak(&d->fft, CLS_TOTAL_LOW, CLS_TOTAL_HIGH);
+#else
+    if (!r->stationary && fft_compute(&d->fft, window, length)) {
+        classifier_band_energy(&d->fft, &r->energy);
+        r->peak = fft_get_peak(&d->fft, CLS_TOTAL_LOW, CLS_TOTAL_HIGH);
+#endif
+
+        if (r->energy.total > 0.0f) {
+            int8_t features[CLS_NUM_FEATURES];
+            uint32_t t0 = cycle_counter_read();
+            classifier_quantize(&r->energy, r->variance, features);
+            uint8_t labels = classifier_run(features);
+            r->classifier_cycles = cycle_counter_read() - t0;
+
+            r->tremor_flag     = (labels & CLS_TREMOR) ? 1 : 0;
+            r->dyskinesia_flag = (labels & CLS_DYSKINESIA) ? 1 : 0;
+            if (labels & CLS_WALKING) {
+                d->had_steps = true;
+                r->walking = true;
+            }
+        }
+    }
+
+    // --- Step 3: FOG detection ---
+    if (d->had_steps) {
+        if (r->stationary) {
+            d->stationary_windows++;
+            if (d->stationary_windows >= 2) {
+                r->fog_flag = 1;
+                d->had_steps = false;
+                d->stationary_windows = 0;
+            }
+        } else {
+            d->stationary_windows = 0;
+        }
+    }
+
+    // --- Step 4: 状态编码 ---
+    if (r->fog_flag) {
+        r->state = 3;
+    } else if (r->tremor_flag) {
+        r->state = 1;
+    } else if (r->dyskinesia_flag) {
+        r->state = 2;
+    } else {
+        r->state = 0;
+    }
+}
+
+// window flags as used by WindowRecord and symptom_stats
+uint8_t detector_flags(const WindowResult *r)
+{
+    return (r->tremor_flag     ? STATS_TREMOR     : 0) |
+           (r->dyskinesia_flag ? STATS_DYSKINESIA : 0) |
+           (r->fog_flag        ? STATS_FOG        : 0) |
+           (r->stationary      ? STATS_STATIONARY : 0) |
+           (r->walking         ? STATS_WALKING    : 0);
+}
@@ -1,25 +1,36 @@
 #include "fft_analysis.h"
 #include <arm_math.h>
 #include <stdio.h>
-
-static float32_t fft_input[2 * FFT_SIZE];   // complex input: interleaved [real, imag]
-static float32_t fft_output[FFT_SIZE];      // magnitude spectrum
+#include "scratch_arena.h"
 
 /*
 Perform FFT on the input signal and calculate the amplitude spectrum.
 Supports length <= FFT_SIZE and automatically performs zero padding.
+The window mean is removed first: with zero padding, an offset would
+leak into the low bins, become the full-band peak and add to the
+CLS_TOTAL band energy.
 */
-bool fft_compute(const float32_t *input, int length)
+bool fft_compute(FftContext *ctx, const float32_t *input, int length)
 {
     if (length <= 0) {
         printf("Invalid input length\r\n");
         return false;
     }
 
-    // copy and zero-pad
+    // complex input: interleaved [real, imag], only alive during this call
+    ScratchRegion work;
+    float32_t *fft_input = scratch_acquire(&work, 2 * FFT_SIZE, "fft");
+    if (fft_input == NULL) {
+        return false;
+    }
+
+    // copy without the mean and zero-pad
     int copyN = (length < FFT_SIZE) ? length : FFT_SIZE;
+    float32_t mean = 0.0f;
+    for (int i = 0; i < copyN; i++) mean += input[i];
+    mean /= copyN;
     for (int i = 0; i < FFT_SIZE; i++) {
-        float32_t x = (i < copyN) ? input[i] : 0.0f; // zero-padding
+        float32_t x = (i < copyN) ? input[i] - mean : 0.0f; // zero-padding
         fft_input[2*i]   = x;      // real
         fft_input[2*i+1] = 0.0f;   // imag
     }
@@ -29,48 +40,78 @@ bool fft_compute(const float32_t *input, int length)
     arm_cfft_init_f32(&cfft_instance, FFT_SIZE);
     arm_cfft_f32(&cfft_instance, fft_input, 0, 1);
 
-    // compute magnitude spectrum
-    arm_cmplx_mag_f32(fft_input, fft_output, FFT_SIZE);
+    // compute magnitude spectrum, real input so only up to Nyquist
+    arm_cmplx_mag_f32(fft_input, ctx->mag, FFT_BINS);
 
+    scratch_release(&work);
     return true;
 }
 
 // Search for the maximum amplitude within the specified frequency range
-float32_t fft_get_band_max(float32_t f_low, float32_t f_high)
+float32_t fft_get_band_max(const FftContext *ctx, float32_t f_low, float32_t f_high)
 {
     float32_t freq_res = (float32_t)SAMPLE_RATE / FFT_SIZE; // Δf
     int start_bin = (int)(f_low / freq_res);
     int end_bin   = (int)(f_high / freq_res);
 
     if (start_bin < 0) start_bin = 0;
-    if (end_bin >= FFT_SIZE/2) end_bin = FFT_SIZE/2 - 1; // up to Nyquist
+    if (end_bin >= FFT_BINS) end_bin = FFT_BINS - 1; // up to Nyquist
 
     float32_t max_val = 0.0f;
     for (int i = start_bin; i <= end_bin; i++) {
-        if (fft_output[i] > max_val) {
-            max_val = fft_output[i];
+        if (ctx->mag[i] > max_val) {
+            max_val = ctx->mag[i];
         }
     }
     return max_val;
 }
 
-// Tremor (3–5Hz)
-bool detect_tremor(void)
+/*
+Peak of mag[start_bin..end_bin] with parabolic interpolation over the
+neighbouring bins, mag[i] being at f0 + i * bin_hz. A peak on the edge
+of the range is returned at its bin centre.
+*/
+SpectralPeak spectral_peak_interp(const float32_t *mag, int start_bin, int end_bin,
+                                  float32_t f0, float32_t bin_hz)
 {
-    float32_t max_val = fft_get_band_max(3.0f, 5.0f);
-    return (max_val > 3.0f); // threshold
+    SpectralPeak peak = { 0.0f, 0.0f };
+    if (end_bin < start_bin) {
+        return peak;
+    }
+
+    int k = start_bin;
+    for (int i = start_bin + 1; i <= end_bin; i++) {
+        if (mag[i] > mag[k]) k = i;
+    }
+
+    float32_t delta = 0.0f;
+    peak.amp = mag[k];
+    if (k > start_bin && k < end_bin) {
+        float32_t a = mag[k - 1], b = mag[k], c = mag[k + 1];
+        float32_t denom = a - 2.0f * b + c;
+        if (denom < 0.0f) {
+            delta = 0.5f * (a - c) / denom;    // within +-0.5 bin
+            peak.amp = b - 0.25f * (a - c) * delta;
+        }
+    }
+    peak.freq = f0 + ((float32_t)k + delta) * bin_hz;
+    return peak;
 }
 
-//Dyskinesia (5–7Hz)
-bool detect_dyskinesia(void)
+// Interpolated peak of the full-band spectrum within the frequency range
+SpectralPeak fft_get_peak(const FftContext *ctx, float32_t f_low, float32_t f_high)
 {
-    float32_t max_val = fft_get_band_max(5.0f, 7.0f);
-    return (max_val > 3.0f); // threshold
+    float32_t freq_res = (float32_t)SAMPLE_RATE / FFT_SIZE;
+    int start_bin = (int)(f_low / freq_res);
+    int end_bin   = (int)(f_high / freq_res);
+    if (start_bin < 0) start_bin = 0;
+    if (end_bin >= FFT_BINS) end_bin = FFT_BINS - 1;
+
+    return spectral_peak_interp(ctx->mag, start_bin, end_bin, 0.0f, freq_res);
 }
-/*
-    detect if the signal is stationary based on variance (static condition)
-*/
-bool is_stationary(const float32_t *buf, int length)
+
+// variance of the window, also used as a classifier feature
+float32_t signal_variance(const float32_t *buf, int length)
 {
     float mean = 0, var = 0;
     for (int i = 0; i < length; i++) mean += buf[i];
@@ -79,24 +120,32 @@ bool is_stationary(const float32_t *buf, int length)
         float diff = buf[i] - mean;
         var += diff * diff;
     }
-    var /= length;
-    return (var < 0.01f); // threshold
+    return var / length;
+}
+
+/*
+    detect if the signal is stationary based on variance (static condition)
+*/
+bool is_stationary(const float32_t *buf, int length)
+{
+    return (signal_variance(buf, length) < STATIONARY_VAR);
 }
 
 /*
 Sum up the values of the FFT amplitude spectrum within the specified 
 frequency range to obtain the total energy of that range.
 */
-float32_t fft_get_band_energy(float32_t f_low, float32_t f_high)
+float32_t fft_get_band_energy(const FftContext *ctx, float32_t f_low, float32_t f_high)
 {
     float32_t freq_res = (float32_t)SAMPLE_RATE / FFT_SIZE;
     int start_bin = (int)(f_low / freq_res);
     int end_bin   = (int)(f_high / freq_res);
-    if (end_bin >= FFT_SIZE/2) end_bin = FFT_SIZE/2 - 1;
+    if (start_bin < 0) start_bin = 0;
+    if (end_bin >= FFT_BINS) end_bin = FFT_BINS - 1;
 
     float32_t energy = 0.0f;
     for (int i = start_bin; i <= end_bin; i++) {
-        energy += fft_output[i];
+        energy += ctx->mag[i];
     }
     return energy;
 }
\ No newline at end of file
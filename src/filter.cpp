@@ -1,29 +1,29 @@
-#include "imu_driver.h"
+#include "filter.h"
+#include <string.h>
+#include <math.h>
 
-#define FILTER_LEN 8
+void filter_moving_average_init(MovingAverageState *st)
+{
+    memset(st, 0, sizeof(*st));
+}
 
 /* Moving Average */
-AccelData filter_accel_moving_average(AccelData in)
+AccelData filter_accel_moving_average(MovingAverageState *st, AccelData in)
 {
-    static float ax_buf[FILTER_LEN] = {0};
-    static float ay_buf[FILTER_LEN] = {0};
-    static float az_buf[FILTER_LEN] = {0};
-    static int idx = 0;
-
     AccelData out = {0};
 
     // store new data
-    ax_buf[idx] = in.ax;
-    ay_buf[idx] = in.ay;
-    az_buf[idx] = in.az;
-    idx = (idx + 1) % FILTER_LEN;
+    st->ax_buf[st->idx] = in.ax;
+    st->ay_buf[st->idx] = in.ay;
+    st->az_buf[st->idx] = in.az;
+    st->idx = (st->idx + 1) % FILTER_LEN;
 
     // calculate average
     float sum_ax = 0, sum_ay = 0, sum_az = 0;
     for (int i = 0; i < FILTER_LEN; i++) {
-        sum_ax += ax_buf[i];
-        sum_ay += ay_buf[i];
-        sum_az += az_buf[i];
+        sum_ax += st->ax_buf[i];
+        sum_ay += st->ay_buf[i];
+        sum_az += st->az_buf[i];
     }
 
     out.ax = sum_ax / FILTER_LEN;
@@ -35,16 +35,65 @@ AccelData filter_accel_moving_average(AccelData in)
 
 #define ALPHA 0.1f  // filter coefficient
 
+void filter_lowpass_init(LowpassState *st)
+{
+    memset(st, 0, sizeof(*st));
+}
+
 /*Exponential Moving Average*/
-AccelData filter_accel_lowpass(AccelData in)
+AccelData filter_accel_lowpass(LowpassState *st, AccelData in)
 {
-    static AccelData filtered = {0};
     AccelData out = {0};
 
-    filtered.ax = filtered.ax + ALPHA * (in.ax - filtered.ax);
-    filtered.ay = filtered.ay + ALPHA * (in.ay - filtered.ay);
-    filtered.az = filtered.az + ALPHA * (in.az - filtered.az);
+    st->filtered.ax = st->filtered.ax + ALPHA * (in.ax - st->filtered.ax);
+    st->filtered.ay = st->filtered.ay + ALPHA * (in.ay - st->filtered.ay);
+    st->filtered.az = st->filtered.az + ALPHA * (in.az - st->filtered.az);
 
-    out = filtered;
+    out = st->filtered;
     return out;
 }
+
+#define AXIS_ALPHA  0.02f   // second-moment EMA, ~1 s at 52 Hz
+#define AXIS_NUDGE  0.01f
+
+void filter_dominant_axis_init(DominantAxisState *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->axis[2] = 1.0f;
+}
+
+/*
+Signed component of (x, y, z) along the axis of largest motion.
+Projecting keeps an oscillation at its own frequency, where a magnitude
+would rectify it to twice the frequency plus DC. The axis follows the
+principal eigenvector of the running second moments by one power
+iteration per sample; the moment matrix is positive semi-definite, so
+the axis never flips sign. The iterate is nudged towards the sensor axis
+with the most energy, so it cannot stay stuck orthogonal to the motion.
+With no motion it keeps its last direction.
+*/
+float filter_dominant_axis_project(DominantAxisState *st, float x, float y, float z)
+{
+    st->xx += AXIS_ALPHA * (x * x - st->xx);
+    st->yy += AXIS_ALPHA * (y * y - st->yy);
+    st->zz += AXIS_ALPHA * (z * z - st->zz);
+    st->xy += AXIS_ALPHA * (x * y - st->xy);
+    st->xz += AXIS_ALPHA * (x * z - st->xz);
+    st->yz += AXIS_ALPHA * (y * z - st->yz);
+
+    float *v = st->axis;
+    float u[3] = { v[0], v[1], v[2] };
+    int k = (st->xx >= st->yy) ? ((st->xx >= st->zz) ? 0 : 2)
+                               : ((st->yy >= st->zz) ? 1 : 2);
+    u[k] += (u[k] >= 0.0f) ? AXIS_NUDGE : -AXIS_NUDGE;
+
+    float nx = st->xx * u[0] + st->xy * u[1] + st->xz * u[2] + 1e-9f * v[0];
+    float ny = st->xy * u[0] + st->yy * u[1] + st->yz * u[2] + 1e-9f * v[1];
+    float nz = st->xz * u[0] + st->yz * u[1] + st->zz * u[2] + 1e-9f * v[2];
+    float r = 1.0f / sqrtf(nx * nx + ny * ny + nz * nz);
+    v[0] = nx * r;
+    v[1] = ny * r;
+    v[2] = nz * r;
+
+    return x * v[0] + y * v[1] + z * v[2];
+}
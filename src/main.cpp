@@ -6,27 +6,78 @@
 #include "filter.h"
 #include "fft_analysis.h"
 #include <arm_math.h>
+#include "scratch_arena.h"
+#include "session_log.h"
+#include "symptom_stats.h"
+#include "detector.h"
+#include "cycle_counter.h"
+#include "QSPIF/QSPIFBlockDevice.h"
 // ==== 新增：BLE 接口封装 ====（lyt修改）
 #include "ble_service.h" 
 
 I2C_HandleTypeDef hi2c2;   // I2C2
 UART_HandleTypeDef huart1;
-float32_t z_buffer[FFT_SIZE];
 
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_I2C2_Init(void);
 static void MX_USART1_UART_Init(void);
 
-#define WINDOW_SEC      3           // 3s for window
-#define WINDOW_SAMPLES  (SAMPLE_RATE * WINDOW_SEC) // 156点，需<=FFT_SIZE
-static float32_t accel_buf[FFT_SIZE];   // buffer for accelerometer
-static float32_t gyro_buf[FFT_SIZE];    // buffer for gyroscope
-static float32_t fused_buf[FFT_SIZE];    // buffer for gyroscope
-static int sample_idx = 0;
+// window buffer, filter, spectrum and FOG state
+static Detector detector;
+
+// RAM budget for the DSP buffers (detector, scratch arena, zoom taps), checked at build time
+#define DSP_RAM_BUDGET  (4 * 1024)
+#if USE_ZOOM_FFT
+#define ZOOM_TAPS_BYTES (2 * ZOOM_FIR_TAPS * sizeof(float32_t))
+#else
+#define ZOOM_TAPS_BYTES 0
+#endif
+static_assert(sizeof(Detector) + SCRATCH_ARENA_BYTES + ZOOM_TAPS_BYTES <= DSP_RAM_BUDGET,
+              "DSP buffers exceed RAM budget");
+
+// session log on the on-board MX25R6435F QSPI flash
+static QSPIFBlockDevice qspi_bd;
+static bool log_ready = false;
+
+// sector erases for the log run here, below the sampling loop's priority,
+// so they only use the idle time between samples
+#define LOG_THREAD_STACK  2048
+#define LOG_QUEUE_BYTES   (8 * EVENTS_EVENT_SIZE)
+static Thread log_thread(osPriorityBelowNormal, LOG_THREAD_STACK);
+static EventQueue log_queue(LOG_QUEUE_BYTES);
+
+static void log_prepare(void)
+{
+    session_log_prepare();
+}
 
-static int stationary_windows = 0; // count of consecutive no-step windows
-static bool had_steps = false; // record if there were steps in previous window
+// 1: also log raw IMU samples, costs ~1.1KB of flash per second
+#define LOG_RAW_IMU       0
+#define RAW_BLOCK_SAMPLES 32
+#if LOG_RAW_IMU
+static RawImuSample raw_block[RAW_BLOCK_SAMPLES];
+static int raw_idx = 0;
+#endif
+
+/*
+Static buffers of every subsystem of this firmware, printed once at
+runtime by ram_report(). mbed-os, the BLE stack's own memory and the
+main thread stack are not included.
+*/
+static const RamUsage ram_usage[] = {
+    { "detector",   sizeof(Detector) },
+#if USE_ZOOM_FFT
+    { "zoom_taps",  ZOOM_TAPS_BYTES },
+#endif
+    { "log",        session_log_ram_bytes() },
+    { "log_thread", LOG_THREAD_STACK + LOG_QUEUE_BYTES },
+#if LOG_RAW_IMU
+    { "raw_imu",    sizeof(raw_block) },
+#endif
+    { "stats",      symptom_stats_ram_bytes() },
+    { "ble",        ble_ram_bytes() },
+};
 
 // ==== 新增：三个症状 flag + 总体 state ====(BLE part)（lyt修改）
 static int tremor_flag     = 0;   // 0/1: 是否检测到 tremor
@@ -53,6 +104,17 @@ int main(void)
     //   - 手机上会看到一个名为 "PD-State" 的 BLE 设备
     ble_init();
 
+    symptom_stats_init();
+    cycle_counter_init();
+    detector_init(&detector);
+
+    log_ready = (session_log_init(&qspi_bd) == 0);
+    if (log_ready) {
+        session_log_stats();
+        log_thread.start(callback(&log_queue, &EventQueue::dispatch_forever));
+        log_queue.call(log_prepare);
+    }
+
     /*
 
     //Test the accelerometer
@@ -84,115 +146,102 @@ int main(void)
         HAL_Delay(20);
     }
         */
-     // 参数：融合权重
-    const float alpha = 0.7f;  // 可调节：0.7 表示加速度计占主导
-
     while (1)
     {
         // Read accelerometer and gyroscope
         AccelData accel = imu_read_accel();
         GyroData  gyro  = imu_read_gyro();
 
-        // Apply simple low-pass filter
-        accel = filter_accel_lowpass(accel);
-
-        // Compute magnitude of accelerometer vector
-        float accel_mag = sqrtf(accel.ax * accel.ax +
-                                accel.ay * accel.ay +
-                                accel.az * accel.az);
-
-        // Compute magnitude of gyroscope vector
-        float gyro_mag = sqrtf(gyro.gx * gyro.gx +
-                            gyro.gy * gyro.gy +
-                            gyro.gz * gyro.gz);
-
-        // --- 融合加速度计和陀螺仪 ---
-        float fused_mag = alpha * accel_mag + (1.0f - alpha) * gyro_mag;
-
-        // Store into buffer
-        if (sample_idx < FFT_SIZE) {
-            fused_buf[sample_idx] = fused_mag;  // 使用融合后的值
-            sample_idx++;
+#if LOG_RAW_IMU
+        if (log_ready) {
+            RawImuSample *raw = &raw_block[raw_idx++];
+            raw->ax = (int16_t)(accel.ax * 1000.0f);
+            raw->ay = (int16_t)(accel.ay * 1000.0f);
+            raw->az = (int16_t)(accel.az * 1000.0f);
+            raw->gx = (int16_t)(gyro.gx * 10.0f);
+            raw->gy = (int16_t)(gyro.gy * 10.0f);
+            raw->gz = (int16_t)(gyro.gz * 10.0f);
+            if (raw_idx == RAW_BLOCK_SAMPLES) {
+                session_log_append(SESSION_REC_RAW_IMU, (uint32_t)time(NULL),
+                                   raw_block, sizeof(raw_block));
+                log_queue.call(log_prepare);
+                raw_idx = 0;
+            }
         }
+#endif
 
-        // When one window is full, perform FFT analysis
-        if (sample_idx >= WINDOW_SAMPLES) 
+        // 去重力 + Low-pass + 融合加速度计和陀螺仪; when one window is full, perform FFT analysis
+        WindowResult result;
+        if (detector_push(&detector, accel, gyro, &result))
         {
             printf("=== Window analysis start ===\r\n");
 
-            tremor_flag     = 0;
-            dyskinesia_flag = 0;
-
-            // --- Step 1: Stationary check ---
-            bool stationary = is_stationary(fused_buf, WINDOW_SAMPLES);
-
-            // --- Step 2: Tremor/Dyskinesia detection ---
-            if (!stationary) {
-                if (fft_compute(fused_buf, WINDOW_SAMPLES)) {
-                    float trem_energy = fft_get_band_energy(2.0f, 3.0f);
-                    float dysk_energy = fft_get_band_energy(4.0f, 5.0f);
-                    float step_energy = fft_get_band_energy(3.0f, 5.0f); 
-                    float total_energy = fft_get_band_energy(0.5f, 10.0f);
-
-                    if (total_energy > 0.0f) {
-                        printf("trem_energy / total_energy = %.3f, dysk_energy / total_energy = %.3f, step_energy / total_energy = %.3f\r\n",
-                            trem_energy / total_energy,
-                            dysk_energy / total_energy,
-                            step_energy / total_energy);
-
-                        if (trem_energy / total_energy > 0.1f) {
-                            tremor_flag = 1;
-                            printf("Tremor detected (3-5Hz)\r\n");
-                        }
-                        if (dysk_energy / total_energy > 0.1f) {
-                            dyskinesia_flag = 1;
-                            printf("Dyskinesia detected (5-7Hz)\r\n");
-                        }
-                        if (step_energy / total_energy > 0.2f) {
-                            had_steps = true;
-                            printf("Walking detected\r\n");
-                        }
-                    }
-                }
-            } else {
+            const BandEnergy &energy = result.energy;
+
+            if (result.stationary) {
                 printf("Stationary: skip tremor/dyskinesia detection\r\n");
+            } else if (energy.total > 0.0f) {
+                printf("trem_energy / total_energy = %.3f, dysk_energy / total_energy = %.3f, step_energy / total_energy = %.3f\r\n",
+                    energy.trem / energy.total,
+                    energy.dysk / energy.total,
+                    energy.step / energy.total);
+                printf("peak: %.2f Hz\r\n", result.peak.freq);
+                printf("classifier: %u cycles\r\n", (unsigned)result.classifier_cycles);
             }
+            printf("orientation: %u cycles/sample (max %u, budget %u)%s\r\n",
+                   (unsigned)result.orientation_cycles_mean,
+                   (unsigned)result.orientation_cycles_max,
+                   (unsigned)ORIENTATION_CYCLE_BUDGET,
+                   result.orientation_cycles_max > ORIENTATION_CYCLE_BUDGET ? " OVER BUDGET" : "");
+            if (result.tremor_flag)     printf("Tremor detected (2-3Hz)\r\n");
+            if (result.dyskinesia_flag) printf("Dyskinesia detected (4-5Hz)\r\n");
+            if (result.walking)         printf("Walking detected\r\n");
+            if (result.fog_flag)        printf("FOG detected (Freezing of Gait)\r\n");
+
+            tremor_flag     = result.tremor_flag;
+            dyskinesia_flag = result.dyskinesia_flag;
+            fog_flag        = result.fog_flag;
+            state           = result.state;
 
-            // --- Step 3: FOG detection ---
-            fog_flag = 0;
-            if (had_steps) {
-                if (stationary) {
-                    stationary_windows++;
-                    if (stationary_windows >= 2) {
-                        printf("FOG detected (Freezing of Gait)\r\n");
-                        fog_flag = 1;
-                        had_steps = false;          
-                        stationary_windows = 0;
-                    }
-                } else {
-                    stationary_windows = 0; 
-                }
-            }
+            // --- Step 5: BLE 广播 ---
+            ble_update(state, tremor_flag, dyskinesia_flag, fog_flag);
 
-            // --- Step 4: 状态编码 ---
-            if (fog_flag) {
-                state = 3;
-            } else if (tremor_flag) {
-                state = 1;
-            } else if (dyskinesia_flag) {
-                state = 2;
-            } else {
-                state = 0;
+            // RTC: seconds since power-on until the phone sets it over BLE (0xA016)
+            uint32_t now = (uint32_t)time(NULL);
+            uint8_t flags = detector_flags(&result);
+
+            // --- Step 6: Session log ---
+            if (log_ready) {
+                WindowRecord rec = {0};
+                rec.state = (uint8_t)state;
+                rec.flags = flags;
+                rec.trem_energy  = energy.trem;
+                rec.dysk_energy  = energy.dysk;
+                rec.step_energy  = energy.step;
+                rec.total_energy = energy.total;
+                session_log_append(SESSION_REC_WINDOW, now, &rec, sizeof(rec));
+                log_queue.call(log_prepare);
             }
 
-            // --- Step 5: BLE 广播 ---
-            ble_update(state, tremor_flag, dyskinesia_flag, fog_flag);
+            // --- Step 7: Long-term summaries ---
+            bool analysed = !result.stationary && energy.total > 0.0f;
+            if (symptom_stats_add(now, flags,
+                                  analysed ? energy.trem / energy.total : -1.0f,
+                                  analysed ? energy.dysk / energy.total : -1.0f)) {
+                ble_update_summary(symptom_stats_minutes(), symptom_stats_hours());
+            }
 
-            sample_idx = 0;
+            // report RAM once the scratch arena has seen a full window
+            static bool ram_reported = false;
+            if (!ram_reported && scratch_high_water() > 0) {
+                ram_report(ram_usage, sizeof(ram_usage) / sizeof(ram_usage[0]));
+                ram_reported = true;
+            }
         }
 
         ble_process();
-        HAL_Delay(1000 / SAMPLE_RATE);
+        // sleep instead of HAL_Delay so the log thread can erase meanwhile
+        ThisThread::sleep_for(std::chrono::milliseconds(1000 / SAMPLE_RATE));
     }
 }
 
@@ -0,0 +1,105 @@
+#include "orientation.h"
+#include <math.h>
+
+#define DEG_TO_RAD  0.01745329252f
+
+static inline float inv_norm(float x)
+{
+    return 1.0f / sqrtf(x + 1e-12f);
+}
+
+void orientation_init(OrientationState *st)
+{
+    st->q0 = 1.0f;
+    st->q1 = 0.0f;
+    st->q2 = 0.0f;
+    st->q3 = 0.0f;
+    st->initialized = false;
+}
+
+/*
+Start from the tilt seen by the accelerometer instead of converging from
+identity. Uses atan2f/sinf/cosf, so call it once before the first update,
+outside any cycle measurement of orientation_update().
+*/
+void orientation_init_from_accel(OrientationState *st, AccelData a)
+{
+    float roll  = atan2f(a.ay, a.az);
+    float pitch = atan2f(-a.ax, sqrtf(a.ay * a.ay + a.az * a.az));
+    float cr = cosf(0.5f * roll),  sr = sinf(0.5f * roll);
+    float cp = cosf(0.5f * pitch), sp = sinf(0.5f * pitch);
+
+    st->q0 = cr * cp;
+    st->q1 = sr * cp;
+    st->q2 = cr * sp;
+    st->q3 = -sr * sp;
+    st->initialized = true;
+}
+
+// gravity direction in the sensor frame (unit, in g)
+AccelData orientation_gravity(const OrientationState *st)
+{
+    AccelData g;
+    g.ax = 2.0f * (st->q1 * st->q3 - st->q0 * st->q2);
+    g.ay = 2.0f * (st->q0 * st->q1 + st->q2 * st->q3);
+    g.az = st->q0 * st->q0 - st->q1 * st->q1 - st->q2 * st->q2 + st->q3 * st->q3;
+    return g;
+}
+
+/*
+One filter step. accel in g, gyro in dps, dt in s.
+Returns linear acceleration (accel minus estimated gravity) in g, sensor frame.
+*/
+AccelData orientation_update(OrientationState *st, AccelData accel, GyroData gyro, float dt)
+{
+    float q0 = st->q0, q1 = st->q1, q2 = st->q2, q3 = st->q3;
+    float gx = gyro.gx * DEG_TO_RAD;
+    float gy = gyro.gy * DEG_TO_RAD;
+    float gz = gyro.gz * DEG_TO_RAD;
+
+    // rate of change from the gyroscope
+    float qd0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qd1 = 0.5f * ( q0 * gx + q2 * gz - q3 * gy);
+    float qd2 = 0.5f * ( q0 * gy - q1 * gz + q3 * gx);
+    float qd3 = 0.5f * ( q0 * gz + q1 * gy - q2 * gx);
+
+    // gradient descent towards the measured gravity direction
+    float r = inv_norm(accel.ax * accel.ax + accel.ay * accel.ay + accel.az * accel.az);
+    float ax = accel.ax * r, ay = accel.ay * r, az = accel.az * r;
+
+    float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+    float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+    float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+    float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+    float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+    float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 +
+               _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+    float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 +
+               _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+    float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+    r = inv_norm(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+    qd0 -= ORIENTATION_BETA * s0 * r;
+    qd1 -= ORIENTATION_BETA * s1 * r;
+    qd2 -= ORIENTATION_BETA * s2 * r;
+    qd3 -= ORIENTATION_BETA * s3 * r;
+
+    q0 += qd0 * dt;
+    q1 += qd1 * dt;
+    q2 += qd2 * dt;
+    q3 += qd3 * dt;
+
+    r = inv_norm(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    st->q0 = q0 * r;
+    st->q1 = q1 * r;
+    st->q2 = q2 * r;
+    st->q3 = q3 * r;
+
+    AccelData g = orientation_gravity(st);
+    AccelData lin;
+    lin.ax = accel.ax - g.ax;
+    lin.ay = accel.ay - g.ay;
+    lin.az = accel.az - g.az;
+    return lin;
+}
@@ -0,0 +1,117 @@
+#include "scratch_arena.h"
+#include <stdio.h>
+#include "dsp_state.h"
+
+DSP_STATE float32_t arena[SCRATCH_ARENA_FLOATS];
+
+/*
+Stack of live regions, top is the most recently acquired one. The arena
+keeps its own copy instead of pointing at the caller's ScratchRegion,
+which usually lives in a stack frame that may already be gone.
+*/
+typedef struct {
+    int offset;
+    int length;
+    const char *owner;
+    bool released;       // released out of order, reclaimed once it is on top
+} LiveRegion;
+
+DSP_STATE LiveRegion live[SCRATCH_MAX_REGIONS];
+DSP_STATE int live_count = 0;
+DSP_STATE int arena_top = 0;       // first free float
+DSP_STATE int arena_peak = 0;      // high-water mark in floats
+DSP_STATE int overlap_errors = 0;  // out-of-order releases seen
+
+/*
+Acquire n_floats from the arena for the given owner.
+Returns NULL if the arena is exhausted or too many regions are live.
+*/
+float32_t *scratch_acquire(ScratchRegion *region, int n_floats, const char *owner)
+{
+    region->offset = -1;
+    region->length = 0;
+    region->owner  = owner;
+
+    if (n_floats <= 0 || live_count >= SCRATCH_MAX_REGIONS ||
+        arena_top + n_floats > SCRATCH_ARENA_FLOATS) {
+        printf("[MEM] %s: scratch request of %d floats failed (used %d/%d)\r\n",
+               owner, n_floats, arena_top, SCRATCH_ARENA_FLOATS);
+        return NULL;
+    }
+
+    region->offset = arena_top;
+    region->length = n_floats;
+    live[live_count].offset   = region->offset;
+    live[live_count].length   = n_floats;
+    live[live_count].owner    = owner;
+    live[live_count].released = false;
+    live_count++;
+
+    arena_top += n_floats;
+    if (arena_top > arena_peak) arena_peak = arena_top;
+
+    return &arena[region->offset];
+}
+
+/*
+Release a region. Only the most recent live region may be released;
+anything else means two lifetimes overlap. That is reported and counted,
+and the region is only marked: its memory comes back when every region
+acquired after it has been released too, so the arena never hands out
+memory that is still in use and never stays blocked.
+*/
+void scratch_release(ScratchRegion *region)
+{
+    if (region->offset < 0) {
+        return; // never acquired
+    }
+
+    int i = live_count - 1;
+    while (i >= 0 && (live[i].offset != region->offset || live[i].released)) {
+        i--;
+    }
+    if (i < 0) {
+        printf("[MEM] %s: release of a region that is not live\r\n", region->owner);
+        overlap_errors++;
+    } else if (i != live_count - 1) {
+        printf("[MEM] %s: out-of-order scratch release, regions overlap with %s\r\n",
+               region->owner, live[live_count - 1].owner);
+        overlap_errors++;
+        live[i].released = true;
+    } else {
+        // pop it and any regions below that were released early
+        live_count--;
+        while (live_count > 0 && live[live_count - 1].released) {
+            live_count--;
+        }
+        arena_top = (live_count > 0) ? live[live_count - 1].offset + live[live_count - 1].length : 0;
+    }
+
+    region->offset = -1;
+    region->length = 0;
+}
+
+int scratch_overlap_errors(void)
+{
+    return overlap_errors;
+}
+
+int scratch_high_water(void)
+{
+    return arena_peak;
+}
+
+void ram_report(const RamUsage *usage, int count)
+{
+    size_t total = SCRATCH_ARENA_BYTES;
+
+    printf("=== Static RAM usage ===\r\n");
+    for (int i = 0; i < count; i++) {
+        printf("  %-10s %6u bytes\r\n", usage[i].subsystem, (unsigned)usage[i].bytes);
+        total += usage[i].bytes;
+    }
+    printf("  %-10s %6u bytes (peak %u)\r\n", "scratch",
+           (unsigned)SCRATCH_ARENA_BYTES,
+           (unsigned)(arena_peak * sizeof(float32_t)));
+    printf("  %-10s %6u bytes\r\n", "total", (unsigned)total);
+}
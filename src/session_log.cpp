@@ -0,0 +1,563 @@
+#include "session_log.h"
+#include "scratch_arena.h"
+#include "MbedCRC.h"
+#include "rtos/Mutex.h"
+#include <stddef.h>
+#include <stdio.h>
+
+using mbed::BlockDevice;
+
+#define SECTOR_MAGIC   0x50444C47u  // "PDLG"
+#define SECTOR_OPEN    0x4F50454Eu  // "OPEN", programmed last when a sector is opened
+#define TS_INVALID     0xFFFFFFFFu
+#define ERASED32       0xFFFFFFFFu
+
+/*
+Written in two steps. session_log_prepare() erases the sector and
+programs erase_count + magic; opening it later programs the rest, with
+state last. A sector whose open fields are still erased is prepared, one
+with state == SECTOR_OPEN holds log data, anything else is torn.
+*/
+typedef struct {
+    uint32_t erase_count;   // how often this sector has been erased
+    uint32_t magic;
+    uint32_t seq;           // increases by one for every opened sector
+    uint32_t first_ts;      // timestamp of the first record
+    uint32_t boot;          // mount that opened the sector
+    uint32_t state;
+} SectorHeader;
+
+#define OPEN_FIELDS_OFF   offsetof(SectorHeader, seq)
+#define OPEN_FIELDS_LEN   (sizeof(SectorHeader) - OPEN_FIELDS_OFF)
+
+enum { SECTOR_INVALID, SECTOR_PREPARED, SECTOR_DATA };
+
+typedef struct {
+    uint8_t  type;          // 0xFF = erased, end of sector
+    uint8_t  reserved;
+    uint16_t length;        // payload length in bytes
+    uint32_t timestamp;
+    uint32_t crc;           // CRC32 over the fields above and the payload
+} RecordHeader;
+
+static BlockDevice *log_bd = NULL;
+static uint32_t sector_size = 0;
+static int n_sectors = 0;
+
+// first-record timestamp per sector, TS_INVALID if the sector holds no log
+static uint32_t sector_first_ts[SESSION_LOG_MAX_SECTORS];
+
+static int head = -1;              // sector currently appended to
+static uint32_t head_off = 0;      // write offset inside head
+static uint32_t head_seq = 0;
+static uint32_t last_ts = 0;
+static uint32_t erase_floor = 0;   // erase count assumed when a header was lost
+
+// this mount
+static uint32_t boot_id = 0;
+static uint32_t ts_offset = 0;     // added to RTC timestamps
+static bool boot_logged = false;
+
+/*
+session_log_prepare() runs on another thread than the appends. The mutex
+guards all state above and the block device; append only try-locks it,
+so a record arriving during a prepare's erase is dropped, not blocked.
+*/
+static rtos::Mutex log_mutex;
+
+// sector erased ahead of time by session_log_prepare()
+static bool prep_ready = false;
+static int prep_sector = -1;
+static uint32_t sync_erases = 0;
+static uint32_t dropped = 0;
+
+static mbed::MbedCRC<POLY_32BIT_ANSI, 32> crc32;
+
+static uint32_t record_crc(const RecordHeader *hdr, const void *payload)
+{
+    uint32_t crc;
+    crc32.compute_partial_start(&crc);
+    crc32.compute_partial(hdr, offsetof(RecordHeader, crc), &crc);
+    crc32.compute_partial(payload, hdr->length, &crc);
+    crc32.compute_partial_stop(&crc);
+    return crc;
+}
+
+static uint32_t sector_addr(int s)
+{
+    return (uint32_t)s * sector_size;
+}
+
+static int sector_kind(const SectorHeader *hdr)
+{
+    if (hdr->magic != SECTOR_MAGIC) {
+        return SECTOR_INVALID;
+    }
+    if (hdr->state == SECTOR_OPEN) {
+        return SECTOR_DATA;
+    }
+    if (hdr->seq == ERASED32 && hdr->first_ts == ERASED32 &&
+        hdr->boot == ERASED32 && hdr->state == ERASED32) {
+        return SECTOR_PREPARED;
+    }
+    return SECTOR_INVALID;
+}
+
+/*
+Read the record at off in sector s into payload.
+Returns 1 for a valid record, 0 at the erased end of the sector and
+-1 if the record is torn or corrupt (the rest of the sector is unusable).
+*/
+static int read_record(int s, uint32_t off, RecordHeader *hdr, uint8_t *payload)
+{
+    if (off + sizeof(RecordHeader) > sector_size) {
+        return -1;
+    }
+    if (log_bd->read(hdr, sector_addr(s) + off, sizeof(RecordHeader)) != 0) {
+        return -1;
+    }
+    if (hdr->type == 0xFF && hdr->length == 0xFFFF) {
+        return 0;
+    }
+    if (hdr->length > SESSION_LOG_MAX_PAYLOAD ||
+        off + sizeof(RecordHeader) + hdr->length > sector_size) {
+        return -1;
+    }
+    if (log_bd->read(payload, sector_addr(s) + off + sizeof(RecordHeader), hdr->length) != 0) {
+        return -1;
+    }
+    return (record_crc(hdr, payload) == hdr->crc) ? 1 : -1;
+}
+
+/*
+Erase sector s and program the first half of its header.
+The erase count survives in the old header, so wear stays visible; a
+sector whose header was lost continues from the lowest count seen.
+*/
+static int erase_sector(int s)
+{
+    SectorHeader hdr;
+    uint32_t erase_count = erase_floor;
+
+    if (log_bd->read(&hdr, sector_addr(s), sizeof(hdr)) == 0 && hdr.magic == SECTOR_MAGIC) {
+        erase_count = hdr.erase_count;
+    }
+
+    sector_first_ts[s] = TS_INVALID;
+    if (log_bd->erase(sector_addr(s), sector_size) != 0) {
+        printf("[LOG] erase of sector %d failed\r\n", s);
+        return -1;
+    }
+
+    hdr.erase_count = erase_count + 1;
+    hdr.magic       = SECTOR_MAGIC;
+    if (log_bd->program(&hdr, sector_addr(s), OPEN_FIELDS_OFF) != 0) {
+        printf("[LOG] header program of sector %d failed\r\n", s);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+Make s the head sector. Uses the pre-erased sector when it is s,
+otherwise erases inline (slow, counted in sync_erases).
+*/
+static int open_sector(int s, uint32_t ts)
+{
+    if (prep_ready && prep_sector == s) {
+        prep_ready = false;
+        prep_sector = -1;
+    } else {
+        sync_erases++;
+        if (erase_sector(s) != 0) {
+            return -1;
+        }
+    }
+
+    SectorHeader hdr;
+    hdr.seq      = ++head_seq;
+    hdr.first_ts = ts;
+    hdr.boot     = boot_id;
+    hdr.state    = SECTOR_OPEN;
+    if (log_bd->program(&hdr.seq, sector_addr(s) + OPEN_FIELDS_OFF, OPEN_FIELDS_LEN) != 0) {
+        printf("[LOG] header program of sector %d failed\r\n", s);
+        return -1;
+    }
+
+    sector_first_ts[s] = ts;
+    head = s;
+    head_off = sizeof(SectorHeader);
+    return 0;
+}
+
+// sector the next open_sector() will use
+static int next_sector(void)
+{
+    return (head < 0) ? 0 : (head + 1) % n_sectors;
+}
+
+// oldest sector still holding log data (first valid one after head)
+static int tail_sector(void)
+{
+    for (int i = 1; i <= n_sectors; i++) {
+        int s = (head + i) % n_sectors;
+        if (sector_first_ts[s] != TS_INVALID) {
+            return s;
+        }
+    }
+    return head;
+}
+
+/*
+Mount the log on bd. Scans every sector header once, then walks the
+records of the newest sector to find the write position.
+*/
+static int mount(BlockDevice *bd)
+{
+    if (bd->init() != 0) {
+        printf("[LOG] block device init failed\r\n");
+        return -1;
+    }
+    if (bd->get_program_size() != 1) {
+        printf("[LOG] unsupported program size %u\r\n", (unsigned)bd->get_program_size());
+        return -1;
+    }
+
+    log_bd = bd;
+    sector_size = (uint32_t)bd->get_erase_size();
+    n_sectors = (int)(bd->size() / sector_size);
+    if (n_sectors > SESSION_LOG_MAX_SECTORS) n_sectors = SESSION_LOG_MAX_SECTORS;
+
+    head = -1;
+    head_off = 0;
+    head_seq = 0;
+    last_ts = 0;
+    erase_floor = ERASED32;
+    ts_offset = 0;
+    boot_logged = false;
+    prep_ready = false;
+    prep_sector = -1;
+    sync_erases = 0;
+    dropped = 0;
+
+    uint32_t max_boot = 0;
+    int prepared = -1;
+    for (int s = 0; s < n_sectors; s++) {
+        SectorHeader hdr;
+        sector_first_ts[s] = TS_INVALID;
+        if (bd->read(&hdr, sector_addr(s), sizeof(hdr)) != 0) {
+            continue;
+        }
+        int kind = sector_kind(&hdr);
+        if (hdr.magic == SECTOR_MAGIC && hdr.erase_count < erase_floor) {
+            erase_floor = hdr.erase_count;
+        }
+        if (kind == SECTOR_PREPARED) {
+            prepared = s;
+        }
+        if (kind != SECTOR_DATA) {
+            continue;
+        }
+        sector_first_ts[s] = hdr.first_ts;
+        if (hdr.boot > max_boot) max_boot = hdr.boot;
+        if (head < 0 || (int32_t)(hdr.seq - head_seq) > 0) {
+            head = s;
+            head_seq = hdr.seq;
+        }
+    }
+    if (erase_floor == ERASED32) erase_floor = 0;
+
+    boot_id = max_boot + 1;
+    if (prepared >= 0 && prepared == next_sector()) {
+        prep_sector = prepared;
+        prep_ready = true;
+    }
+
+    if (head < 0) {
+        printf("[LOG] empty log, %d sectors of %u bytes\r\n", n_sectors, (unsigned)sector_size);
+        return 0;
+    }
+
+    // find the end of the newest sector; a torn record closes the sector
+    ScratchRegion region;
+    uint8_t *payload = (uint8_t *)scratch_acquire(&region,
+        SESSION_LOG_MAX_PAYLOAD / sizeof(float32_t), "log");
+    if (payload == NULL) {
+        return -1;
+    }
+
+    RecordHeader rec;
+    uint32_t off = sizeof(SectorHeader);
+    last_ts = sector_first_ts[head];
+    while (true) {
+        int r = read_record(head, off, &rec, payload);
+        if (r == 0) {
+            head_off = off;
+            break;
+        }
+        if (r < 0) {
+            head_off = sector_size;
+            printf("[LOG] torn record at sector %d offset %u, sector closed\r\n",
+                   head, (unsigned)off);
+            break;
+        }
+        // a mount that never opened a sector of its own only shows up here
+        if (rec.type == SESSION_REC_BOOT && rec.length == sizeof(BootRecord)) {
+            const BootRecord *b = (const BootRecord *)payload;
+            if (b->boot >= boot_id) boot_id = b->boot + 1;
+        }
+        last_ts = rec.timestamp;
+        off += sizeof(RecordHeader) + rec.length;
+    }
+
+    scratch_release(&region);
+
+    printf("[LOG] mounted, boot %u, head sector %d offset %u, last ts %u\r\n",
+           (unsigned)boot_id, head, (unsigned)head_off, (unsigned)last_ts);
+    return 0;
+}
+
+int session_log_init(BlockDevice *bd)
+{
+    log_mutex.lock();
+    int r = mount(bd);
+    log_mutex.unlock();
+    return r;
+}
+
+// log time of an RTC timestamp: offset for this mount, non-decreasing
+static uint32_t log_time(uint32_t rtc)
+{
+    uint32_t ts = rtc + ts_offset;
+    if (ts < rtc) ts = TS_INVALID - 1;     // wrapped
+    if (ts < last_ts) ts = last_ts;
+    if (ts == TS_INVALID) ts = TS_INVALID - 1;
+    return ts;
+}
+
+static int append_record(uint8_t type, uint32_t timestamp,
+                         const void *payload, uint16_t length)
+{
+    uint32_t total = sizeof(RecordHeader) + length;
+    if (head < 0 || head_off + total > sector_size) {
+        if (open_sector(next_sector(), timestamp) != 0) {
+            return -1;
+        }
+    }
+
+    RecordHeader rec;
+    rec.type      = type;
+    rec.reserved  = 0;
+    rec.length    = length;
+    rec.timestamp = timestamp;
+    rec.crc       = record_crc(&rec, payload);
+
+    uint32_t addr = sector_addr(head) + head_off;
+    // advance first: if either program fails the slot is never reused
+    head_off += total;
+    if (log_bd->program(&rec, addr, sizeof(rec)) != 0 ||
+        (length > 0 && log_bd->program(payload, addr + sizeof(rec), length) != 0)) {
+        printf("[LOG] program failed at sector %d\r\n", head);
+        return -1;
+    }
+
+    last_ts = timestamp;
+    return 0;
+}
+
+/*
+Append one record with its RTC timestamp. The first append of a mount
+writes the BootRecord and fixes the offset: an RTC that restarted behind
+the log continues from the last logged time instead of being clamped to
+it. Within a mount timestamps are clamped to be non-decreasing so the
+ring stays sorted by time.
+
+Never waits for a running prepare; the record is dropped instead
+(counted), because the flash is busy and waiting would stall the caller.
+*/
+static int append_locked(uint8_t type, uint32_t timestamp,
+                         const void *payload, uint16_t length)
+{
+    if (log_bd == NULL || type == 0xFF || length > SESSION_LOG_MAX_PAYLOAD) {
+        return -1;
+    }
+
+    if (!boot_logged) {
+        ts_offset = (timestamp < last_ts) ? last_ts - timestamp : 0;
+        BootRecord boot = { boot_id, timestamp };
+        if (append_record(SESSION_REC_BOOT, log_time(timestamp), &boot, sizeof(boot)) != 0) {
+            return -1;
+        }
+        boot_logged = true;
+    }
+
+    return append_record(type, log_time(timestamp), payload, length);
+}
+
+int session_log_append(uint8_t type, uint32_t timestamp,
+                       const void *payload, uint16_t length)
+{
+    if (!log_mutex.trylock()) {
+        dropped++;      // only the appending thread writes it
+        return -1;
+    }
+    int r = append_locked(type, timestamp, payload, length);
+    log_mutex.unlock();
+    return r;
+}
+
+/*
+Erase the sector the log will move to next, so the append that fills
+the current sector does not have to. Blocking, and holds the log for
+the whole erase; call it outside the sampling path.
+Does nothing if the next sector is already prepared.
+*/
+static int prepare_locked(void)
+{
+    if (log_bd == NULL || n_sectors < 2) {
+        return -1;
+    }
+
+    int next = next_sector();
+    if (prep_ready && prep_sector == next) {
+        return 0;
+    }
+
+    prep_ready = false;
+    prep_sector = -1;
+    if (erase_sector(next) != 0) {
+        return -1;
+    }
+    prep_sector = next;
+    prep_ready = true;
+    return 0;
+}
+
+int session_log_prepare(void)
+{
+    log_mutex.lock();
+    int r = prepare_locked();
+    log_mutex.unlock();
+    return r;
+}
+
+/*
+Deliver every record with t_from <= timestamp <= t_to to cb, oldest first.
+Binary search over the cached sector timestamps picks the first sector.
+Holds the log while reading, appends meanwhile are dropped.
+*/
+static int read_range_locked(uint32_t t_from, uint32_t t_to,
+                             session_log_cb cb, void *ctx)
+{
+    if (log_bd == NULL || head < 0) {
+        return 0;
+    }
+
+    int tail = tail_sector();
+    int count = (head - tail + n_sectors) % n_sectors + 1;
+
+    // last ring position starting strictly before t_from: records equal to
+    // t_from may still sit at the end of the sector before the first match
+    int lo = 0, hi = count - 1, first = 0;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (sector_first_ts[(tail + mid) % n_sectors] < t_from) {
+            first = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    ScratchRegion region;
+    uint8_t *payload = (uint8_t *)scratch_acquire(&region,
+        SESSION_LOG_MAX_PAYLOAD / sizeof(float32_t), "log");
+    if (payload == NULL) {
+        return -1;
+    }
+
+    int delivered = 0;
+    bool done = false;
+    for (int i = first; i < count && !done; i++) {
+        int s = (tail + i) % n_sectors;
+        if (sector_first_ts[s] > t_to) {
+            break;
+        }
+
+        RecordHeader rec;
+        uint32_t off = sizeof(SectorHeader);
+        while (read_record(s, off, &rec, payload) > 0) {
+            off += sizeof(RecordHeader) + rec.length;
+            if (rec.timestamp < t_from) {
+                continue;
+            }
+            if (rec.timestamp > t_to ||
+                !cb(rec.type, rec.timestamp, payload, rec.length, ctx)) {
+                done = true;
+                break;
+            }
+            delivered++;
+        }
+    }
+
+    scratch_release(&region);
+    return delivered;
+}
+
+int session_log_read_range(uint32_t t_from, uint32_t t_to,
+                           session_log_cb cb, void *ctx)
+{
+    log_mutex.lock();
+    int r = read_range_locked(t_from, t_to, cb, ctx);
+    log_mutex.unlock();
+    return r;
+}
+
+size_t session_log_ram_bytes(void)
+{
+    return sizeof(sector_first_ts) + sizeof(crc32);
+}
+
+// wear is read back from the sector headers, so this scans the flash
+void session_log_get_stats(SessionLogStats *st)
+{
+    log_mutex.lock();
+    st->sectors_used  = 0;
+    st->sectors_total = n_sectors;
+    st->head          = head;
+    st->head_offset   = head_off;
+    st->min_erase     = ERASED32;
+    st->max_erase     = 0;
+    st->boot          = boot_id;
+    st->next_prepared = (prep_ready && prep_sector == next_sector());
+    st->sync_erases   = sync_erases;
+    st->dropped       = dropped;
+
+    for (int s = 0; s < n_sectors && log_bd != NULL; s++) {
+        SectorHeader hdr;
+        if (sector_first_ts[s] != TS_INVALID) st->sectors_used++;
+        if (log_bd->read(&hdr, sector_addr(s), sizeof(hdr)) != 0 || hdr.magic != SECTOR_MAGIC) {
+            continue;
+        }
+        if (hdr.erase_count < st->min_erase) st->min_erase = hdr.erase_count;
+        if (hdr.erase_count > st->max_erase) st->max_erase = hdr.erase_count;
+    }
+    if (st->min_erase > st->max_erase) st->min_erase = st->max_erase;
+    log_mutex.unlock();
+}
+
+void session_log_stats(void)
+{
+    if (log_bd == NULL) {
+        printf("[LOG] not mounted\r\n");
+        return;
+    }
+
+    SessionLogStats st;
+    session_log_get_stats(&st);
+    printf("[LOG] %d/%d sectors used, head %d @%u, erase count %u..%u, "
+           "boot %u, %u inline erases, %u dropped\r\n",
+           st.sectors_used, st.sectors_total, st.head, (unsigned)st.head_offset,
+           (unsigned)st.min_erase, (unsigned)st.max_erase, (unsigned)st.boot,
+           (unsigned)st.sync_erases, (unsigned)st.dropped);
+}
@@ -0,0 +1,189 @@
+#include "symptom_stats.h"
+#include <string.h>
+
+typedef struct {
+    uint32_t id;            // minute or hour index, timestamp / period
+    uint16_t windows;
+    uint16_t tremor;
+    uint16_t dyskinesia;
+    uint16_t fog;
+    uint16_t stationary;
+    uint16_t walking;
+    uint16_t ratio_count;   // windows that contributed a band ratio
+    uint16_t trem_hist[STATS_RATIO_BINS];
+    uint16_t dysk_hist[STATS_RATIO_BINS];
+} Accumulator;
+
+static Accumulator cur_minute;
+static Accumulator cur_hour;
+
+// rings hold finished periods; unused slots are zero
+static MinuteSummary minutes[STATS_MINUTES];
+static HourSummary hours[STATS_HOURS];
+static int minute_pos = 0;
+static int hour_pos = 0;
+
+static void acc_reset(Accumulator *acc, uint32_t id)
+{
+    memset(acc, 0, sizeof(*acc));
+    acc->id = id;
+}
+
+// fine around the thresholds, coarse where ratios only need to be ranked
+static const float ratio_edges[STATS_RATIO_BINS + 1] = {
+    0.00f, 0.02f, 0.04f, 0.06f, 0.08f, 0.10f, 0.12f, 0.14f, 0.16f,
+    0.18f, 0.20f, 0.25f, 0.30f, 0.40f, 0.50f, 0.75f, 1.00f,
+};
+
+static int ratio_bin(float ratio)
+{
+    int bin = 0;
+    while (bin < STATS_RATIO_BINS - 1 && ratio >= ratio_edges[bin + 1]) {
+        bin++;
+    }
+    return bin;
+}
+
+static void acc_add(Accumulator *acc, uint8_t flags, bool has_ratio,
+                    float trem_ratio, float dysk_ratio)
+{
+    acc->windows++;
+    if (flags & STATS_TREMOR)     acc->tremor++;
+    if (flags & STATS_DYSKINESIA) acc->dyskinesia++;
+    if (flags & STATS_FOG)        acc->fog++;
+    if (flags & STATS_STATIONARY) acc->stationary++;
+    if (flags & STATS_WALKING)    acc->walking++;
+
+    if (has_ratio) {
+        acc->ratio_count++;
+        acc->trem_hist[ratio_bin(trem_ratio)]++;
+        acc->dysk_hist[ratio_bin(dysk_ratio)]++;
+    }
+}
+
+/*
+q-quantile of a ratio histogram, linearly interpolated inside the bin
+that crosses q * count. Returned scaled to 0..255 = 0..1.
+*/
+static uint8_t hist_percentile(const uint16_t *hist, uint16_t count, float q)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    float target = q * count;
+    float cum = 0.0f;
+    for (int i = 0; i < STATS_RATIO_BINS; i++) {
+        if (hist[i] > 0 && cum + hist[i] >= target) {
+            float frac = (target - cum) / hist[i];
+            float ratio = ratio_edges[i] + frac * (ratio_edges[i + 1] - ratio_edges[i]);
+            return (uint8_t)(ratio * 255.0f + 0.5f);
+        }
+        cum += hist[i];
+    }
+    return 255;
+}
+
+static uint8_t sat8(uint16_t v)
+{
+    return (v > 255) ? 255 : (uint8_t)v;
+}
+
+static uint8_t duty(uint16_t n, uint16_t windows)
+{
+    return (windows == 0) ? 0 : (uint8_t)((uint32_t)n * 255 / windows);
+}
+
+static void close_minute(void)
+{
+    MinuteSummary *m = &minutes[minute_pos];
+    m->minute_id  = (uint16_t)cur_minute.id;
+    m->windows    = sat8(cur_minute.windows);
+    m->tremor     = sat8(cur_minute.tremor);
+    m->dyskinesia = sat8(cur_minute.dyskinesia);
+    m->fog        = sat8(cur_minute.fog);
+    m->walking    = sat8(cur_minute.walking);
+    m->trem_p50   = hist_percentile(cur_minute.trem_hist, cur_minute.ratio_count, 0.5f);
+    minute_pos = (minute_pos + 1) % STATS_MINUTES;
+}
+
+static void close_hour(void)
+{
+    HourSummary *h = &hours[hour_pos];
+    h->start_ts        = cur_hour.id * 3600;
+    h->windows         = cur_hour.windows;
+    h->tremor_duty     = duty(cur_hour.tremor, cur_hour.windows);
+    h->dysk_duty       = duty(cur_hour.dyskinesia, cur_hour.windows);
+    h->stationary_duty = duty(cur_hour.stationary, cur_hour.windows);
+    h->walking_duty    = duty(cur_hour.walking, cur_hour.windows);
+    h->fog_events      = sat8(cur_hour.fog);
+    h->trem_p50        = hist_percentile(cur_hour.trem_hist, cur_hour.ratio_count, 0.5f);
+    h->trem_p90        = hist_percentile(cur_hour.trem_hist, cur_hour.ratio_count, 0.9f);
+    h->dysk_p50        = hist_percentile(cur_hour.dysk_hist, cur_hour.ratio_count, 0.5f);
+    h->dysk_p90        = hist_percentile(cur_hour.dysk_hist, cur_hour.ratio_count, 0.9f);
+    h->reserved        = 0;
+    hour_pos = (hour_pos + 1) % STATS_HOURS;
+}
+
+void symptom_stats_init(void)
+{
+    memset(minutes, 0, sizeof(minutes));
+    memset(hours, 0, sizeof(hours));
+    minute_pos = 0;
+    hour_pos = 0;
+    acc_reset(&cur_minute, 0);
+    acc_reset(&cur_hour, 0);
+}
+
+/*
+Fold one window into the running minute/hour. A ratio is only counted
+when the window was analysed (not stationary, non-zero energy), pass a
+negative trem_ratio otherwise.
+*/
+bool symptom_stats_add(uint32_t timestamp, uint8_t flags,
+                       float trem_ratio, float dysk_ratio)
+{
+    uint32_t minute_id = timestamp / 60;
+    uint32_t hour_id   = timestamp / 3600;
+    bool closed = false;
+
+    if (cur_minute.windows == 0) {
+        cur_minute.id = minute_id;
+    } else if (minute_id != cur_minute.id) {
+        close_minute();
+        acc_reset(&cur_minute, minute_id);
+        closed = true;
+    }
+
+    if (cur_hour.windows == 0) {
+        cur_hour.id = hour_id;
+    } else if (hour_id != cur_hour.id) {
+        close_hour();
+        acc_reset(&cur_hour, hour_id);
+    }
+
+    bool has_ratio = (trem_ratio >= 0.0f);
+    acc_add(&cur_minute, flags, has_ratio, trem_ratio, dysk_ratio);
+    acc_add(&cur_hour, flags, has_ratio, trem_ratio, dysk_ratio);
+    return closed;
+}
+
+const float *stats_ratio_edges(void)
+{
+    return ratio_edges;
+}
+
+size_t symptom_stats_ram_bytes(void)
+{
+    return sizeof(cur_minute) + sizeof(cur_hour) + sizeof(minutes) + sizeof(hours);
+}
+
+const MinuteSummary *symptom_stats_minutes(void)
+{
+    return minutes;
+}
+
+const HourSummary *symptom_stats_hours(void)
+{
+    return hours;
+}
@@ -0,0 +1,162 @@
+#include "zoom_fft.h"
+#include <arm_math.h>
+#include <stdio.h>
+#include "scratch_arena.h"
+#include "dsp_state.h"
+
+static_assert(2 * ZOOM_FFT_SIZE <= SCRATCH_ARENA_FLOATS, "zoom FFT work buffer must fit in the arena");
+static_assert(ZOOM_FIR_TAPS % 2 == 0, "even tap count keeps the sinc off t = 0");
+
+/*
+Decimation low-pass shifted to ZOOM_CENTER: taps[k] = h[k] * e^(-j w k),
+h a Hamming windowed sinc. Filtering the real input with these complex
+taps is the same as demodulating first and low-pass filtering after, but
+needs no full-rate complex buffer. Built once, same for every context.
+*/
+DSP_STATE float32_t taps[2 * ZOOM_FIR_TAPS];
+DSP_STATE bool taps_ready = false;
+
+static void build_taps(void)
+{
+    const float32_t half = 0.5f * (ZOOM_FIR_TAPS - 1);
+    const float32_t fc = ZOOM_FIR_CUTOFF / SAMPLE_RATE;     // cycles per sample
+    const float32_t w0 = 2.0f * PI * ZOOM_CENTER / SAMPLE_RATE;
+    float32_t gain = 0.0f;
+
+    for (int k = 0; k < ZOOM_FIR_TAPS; k++) {
+        float32_t t = (float32_t)k - half;
+        float32_t h = 2.0f * fc * sinf(2.0f * PI * fc * t) / (2.0f * PI * fc * t);
+        h *= 0.54f - 0.46f * cosf(2.0f * PI * k / (ZOOM_FIR_TAPS - 1));
+        taps[2*k]   = h * cosf(w0 * k);
+        taps[2*k+1] = -h * sinf(w0 * k);
+        gain += h;
+    }
+    // unity gain at ZOOM_CENTER
+    for (int k = 0; k < 2 * ZOOM_FIR_TAPS; k++) {
+        taps[k] /= gain;
+    }
+    taps_ready = true;
+}
+
+/*
+Zoom spectrum of the window around ZOOM_CENTER.
+Outputs every ZOOM_DECIM-th input sample with the filter centred on it,
+samples outside the window count as zero after removing the mean, so
+ceil(length / ZOOM_DECIM) points reach the FFT (39 for a 3 s window).
+*/
+bool zoom_fft_compute(ZoomFftContext *ctx, const float32_t *input, int length)
+{
+    if (length <= ZOOM_FIR_TAPS) {
+        printf("Invalid input length\r\n");
+        return false;
+    }
+    if (!taps_ready) {
+        build_taps();
+    }
+
+    ScratchRegion work;
+    float32_t *buf = scratch_acquire(&work, 2 * ZOOM_FFT_SIZE, "zoom_fft");
+    if (buf == NULL) {
+        return false;
+    }
+
+    float32_t mean = 0.0f;
+    for (int i = 0; i < length; i++) mean += input[i];
+    mean /= length;
+
+    int n_out = (length + ZOOM_DECIM - 1) / ZOOM_DECIM;
+    if (n_out > ZOOM_FFT_SIZE) n_out = ZOOM_FFT_SIZE;
+
+    // phase of the demodulator at the first tap of output m: e^(-j w0 DECIM m)
+    const float32_t w_step = 2.0f * PI * ZOOM_CENTER * ZOOM_DECIM / SAMPLE_RATE;
+    const float32_t rot_re = arm_cos_f32(w_step), rot_im = -arm_sin_f32(w_step);
+    float32_t ph_re = 1.0f, ph_im = 0.0f;
+
+    // Hann window over n_out points, also by rotation
+    const float32_t w_hann = 2.0f * PI / (n_out - 1);
+    const float32_t hr_re = arm_cos_f32(w_hann), hr_im = arm_sin_f32(w_hann);
+    float32_t hc_re = 1.0f, hc_im = 0.0f;
+
+    for (int m = 0; m < n_out; m++) {
+        int first = m * ZOOM_DECIM - ZOOM_FIR_TAPS / 2;
+        int k_lo = (first < 0) ? -first : 0;
+        int k_hi = (first + ZOOM_FIR_TAPS > length) ? length - first : ZOOM_FIR_TAPS;
+
+        float32_t acc_re = 0.0f, acc_im = 0.0f;
+        for (int k = k_lo; k < k_hi; k++) {
+            float32_t x = input[first + k] - mean;
+            acc_re += taps[2*k]   * x;
+            acc_im += taps[2*k+1] * x;
+        }
+
+        // taps start at phase 0, so rotate by the phase of the first input sample
+        float32_t win = 0.5f - 0.5f * hc_re;
+        buf[2*m]   = win * (acc_re * ph_re - acc_im * ph_im);
+        buf[2*m+1] = win * (acc_re * ph_im + acc_im * ph_re);
+
+        float32_t t = ph_re * rot_re - ph_im * rot_im;
+        ph_im = ph_re * rot_im + ph_im * rot_re;
+        ph_re = t;
+        t = hc_re * hr_re - hc_im * hr_im;
+        hc_im = hc_re * hr_im + hc_im * hr_re;
+        hc_re = t;
+    }
+    for (int i = 2 * n_out; i < 2 * ZOOM_FFT_SIZE; i++) {
+        buf[i] = 0.0f;   // zero-padding
+    }
+
+    arm_cfft_instance_f32 cfft_instance;
+    arm_cfft_init_f32(&cfft_instance, ZOOM_FFT_SIZE);
+    arm_cfft_f32(&cfft_instance, buf, 0, 1);
+
+    // negative frequencies first, so mag[] runs upwards from ZOOM_F_START
+    arm_cmplx_mag_f32(buf + ZOOM_FFT_SIZE, ctx->mag, ZOOM_FFT_SIZE / 2);
+    arm_cmplx_mag_f32(buf, ctx->mag + ZOOM_FFT_SIZE / 2, ZOOM_FFT_SIZE / 2);
+
+    scratch_release(&work);
+    return true;
+}
+
+static void band_bins(float32_t f_low, float32_t f_high, int *start_bin, int *end_bin)
+{
+    *start_bin = (int)((f_low - ZOOM_F_START) / ZOOM_BIN_HZ);
+    *end_bin   = (int)((f_high - ZOOM_F_START) / ZOOM_BIN_HZ);
+    if (*start_bin < 0) *start_bin = 0;
+    if (*end_bin >= ZOOM_FFT_SIZE) *end_bin = ZOOM_FFT_SIZE - 1;
+}
+
+// Search for the maximum amplitude within the specified frequency range
+float32_t zoom_fft_get_band_max(const ZoomFftContext *ctx, float32_t f_low, float32_t f_high)
+{
+    int start_bin, end_bin;
+    band_bins(f_low, f_high, &start_bin, &end_bin);
+
+    float32_t max_val = 0.0f;
+    for (int i = start_bin; i <= end_bin; i++) {
+        if (ctx->mag[i] > max_val) {
+            max_val = ctx->mag[i];
+        }
+    }
+    return max_val;
+}
+
+// Sum of the zoom magnitude spectrum within the frequency range
+float32_t zoom_fft_get_band_energy(const ZoomFftContext *ctx, float32_t f_low, float32_t f_high)
+{
+    int start_bin, end_bin;
+    band_bins(f_low, f_high, &start_bin, &end_bin);
+
+    float32_t energy = 0.0f;
+    for (int i = start_bin; i <= end_bin; i++) {
+        energy += ctx->mag[i];
+    }
+    return energy;
+}
+
+// Interpolated peak frequency / amplitude within the frequency range
+SpectralPeak zoom_fft_peak(const ZoomFftContext *ctx, float32_t f_low, float32_t f_high)
+{
+    int start_bin, end_bin;
+    band_bins(f_low, f_high, &start_bin, &end_bin);
+    return spectral_peak_interp(ctx->mag, start_bin, end_bin, ZOOM_F_START, ZOOM_BIN_HZ);
+}
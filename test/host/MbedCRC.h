@@ -0,0 +1,42 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Host stand-in for mbed's MbedCRC, CRC-32 (ANSI, reflected) only, with the
+same partial-compute API as on the device.
+*/
+
+#define POLY_32BIT_ANSI  0x04C11DB7u
+
+namespace mbed {
+
+template <uint32_t Polynomial, int Width>
+class MbedCRC {
+public:
+    int32_t compute_partial_start(uint32_t *crc)
+    {
+        *crc = 0xFFFFFFFFu;
+        return 0;
+    }
+
+    int32_t compute_partial(const void *buffer, size_t size, uint32_t *crc)
+    {
+        const uint8_t *p = (const uint8_t *)buffer;
+        for (size_t i = 0; i < size; i++) {
+            *crc ^= p[i];
+            for (int k = 0; k < 8; k++) {
+                *crc = (*crc >> 1) ^ (0xEDB88320u & (0u - (*crc & 1u)));
+            }
+        }
+        return 0;
+    }
+
+    int32_t compute_partial_stop(uint32_t *crc)
+    {
+        *crc ^= 0xFFFFFFFFu;
+        return 0;
+    }
+};
+
+} // namespace mbed
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+
+/*
+Host stand-in for mbed's BlockDevice interface, so src/session_log.cpp
+builds in env:native. Only what the log uses.
+*/
+
+typedef uint64_t bd_addr_t;
+typedef uint64_t bd_size_t;
+
+namespace mbed {
+
+class BlockDevice {
+public:
+    virtual ~BlockDevice() {}
+    virtual int init() = 0;
+    virtual int deinit() = 0;
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size) = 0;
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size) = 0;
+    virtual int erase(bd_addr_t addr, bd_size_t size) = 0;
+    virtual bd_size_t get_read_size() const = 0;
+    virtual bd_size_t get_program_size() const = 0;
+    virtual bd_size_t get_erase_size() const = 0;
+    virtual bd_size_t size() const = 0;
+};
+
+} // namespace mbed
@@ -0,0 +1,133 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "blockdevice/BlockDevice.h"
+
+/*
+File-backed NOR flash simulator for host tests.
+
+Behaves like the MX25R6435F as seen through QSPIFBlockDevice: erase sets
+a 4 KB sector to 0xFF, program can only clear bits (a program over
+non-erased bytes is counted as a violation), program size 1. The image
+is written through to a file, so a second FlashSim on the same path sees
+what survived, like the flash after a reboot.
+
+Power loss: cut_after(n) lets n more bytes be programmed (an erase counts
+as one unit and is left half done if cut); the operation that crosses
+the budget stops mid-way and every later call fails until power_cycle().
+*/
+class FlashSim : public mbed::BlockDevice {
+public:
+    FlashSim(const char *path, bd_size_t sectors, bd_size_t sector_size = 4096)
+        : _sector_size(sector_size), _image(sectors * sector_size, 0xFF),
+          _erases(sectors, 0), _file(NULL), _budget(-1), _dead(false),
+          _violations(0), _erase_ops(0), _program_bytes(0)
+    {
+        _file = fopen(path, "r+b");
+        if (_file != NULL) {
+            size_t n = fread(_image.data(), 1, _image.size(), _file);
+            (void)n;
+        } else {
+            _file = fopen(path, "w+b");
+            flush(0, _image.size());
+        }
+    }
+
+    ~FlashSim()
+    {
+        if (_file != NULL) fclose(_file);
+    }
+
+    int init() { return 0; }
+    int deinit() { return 0; }
+
+    int read(void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        if (_dead || addr + size > _image.size()) return -1;
+        memcpy(buffer, &_image[addr], size);
+        return 0;
+    }
+
+    int program(const void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        if (_dead || addr + size > _image.size()) return -1;
+        const uint8_t *p = (const uint8_t *)buffer;
+        for (bd_size_t i = 0; i < size; i++) {
+            if (!spend()) {
+                flush(addr, i);
+                return -1;
+            }
+            if ((p[i] & ~_image[addr + i]) != 0) _violations++;
+            _image[addr + i] &= p[i];
+        }
+        _program_bytes += size;
+        flush(addr, size);
+        return 0;
+    }
+
+    int erase(bd_addr_t addr, bd_size_t size)
+    {
+        if (_dead || addr % _sector_size != 0 || size % _sector_size != 0 ||
+            addr + size > _image.size()) {
+            return -1;
+        }
+        for (bd_addr_t a = addr; a < addr + size; a += _sector_size) {
+            if (!spend()) {
+                memset(&_image[a], 0xFF, _sector_size / 2);   // interrupted erase
+                flush(a, _sector_size);
+                return -1;
+            }
+            memset(&_image[a], 0xFF, _sector_size);
+            _erases[a / _sector_size]++;
+            _erase_ops++;
+            flush(a, _sector_size);
+        }
+        return 0;
+    }
+
+    bd_size_t get_read_size() const { return 1; }
+    bd_size_t get_program_size() const { return 1; }
+    bd_size_t get_erase_size() const { return _sector_size; }
+    bd_size_t size() const { return _image.size(); }
+
+    // power loss after n more programmed bytes / erases
+    void cut_after(long n) { _budget = n; }
+    void power_cycle() { _budget = -1; _dead = false; }
+    bool dead() const { return _dead; }
+
+    unsigned erases(int sector) const { return _erases[sector]; }
+    unsigned long erase_ops() const { return _erase_ops; }
+    unsigned long program_bytes() const { return _program_bytes; }
+    unsigned long violations() const { return _violations; }
+
+private:
+    bool spend()
+    {
+        if (_budget < 0) return true;
+        if (_budget == 0) {
+            _dead = true;
+            return false;
+        }
+        _budget--;
+        return true;
+    }
+
+    void flush(bd_addr_t addr, bd_size_t size)
+    {
+        if (_file == NULL || size == 0) return;
+        fseek(_file, (long)addr, SEEK_SET);
+        fwrite(&_image[addr], 1, size, _file);
+        fflush(_file);
+    }
+
+    bd_size_t _sector_size;
+    std::vector<uint8_t> _image;
+    std::vector<unsigned> _erases;
+    FILE *_file;
+    long _budget;
+    bool _dead;
+    unsigned long _violations;
+    unsigned long _erase_ops;
+    unsigned long _program_bytes;
+};
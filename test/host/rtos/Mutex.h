@@ -0,0 +1,21 @@
+#pragma once
+#include <mutex>
+
+/*
+Host stand-in for mbed's rtos::Mutex, so src/session_log.cpp builds in
+env:native. Recursive like the RTOS mutex.
+*/
+
+namespace rtos {
+
+class Mutex {
+public:
+    void lock() { _m.lock(); }
+    bool trylock() { return _m.try_lock(); }
+    void unlock() { _m.unlock(); }
+
+private:
+    std::recursive_mutex _m;
+};
+
+} // namespace rtos
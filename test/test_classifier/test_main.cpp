@@ -0,0 +1,80 @@
+#include <unity.h>
+#include <stdio.h>
+#include "classifier.h"
+
+/*
+The default (--rules) model on quantized features must make the same
+decision as the fixed ratio thresholds it was generated from.
+*/
+
+void setUp(void)
+{
+    classifier_set_model(NULL);
+}
+
+void tearDown(void) {}
+
+static uint8_t classify(float trem, float dysk, float step)
+{
+    BandEnergy e;
+    e.trem  = trem;
+    e.dysk  = dysk;
+    e.step  = step;
+    e.total = 1.0f;
+    int8_t features[CLS_NUM_FEATURES];
+    classifier_quantize(&e, 0.05f, features);
+    return classifier_run(features);
+}
+
+// ratios swept in steps of 0.0005, skipping one quantization ulp around the threshold
+static void check_rule(uint8_t label, float threshold, int which)
+{
+    for (int i = 0; i <= 800; i++) {
+        float r = i * 0.0005f;
+        if (r > threshold - 1e-5f && r < threshold + 1e-5f) continue;
+        float v[3] = { 0.0f, 0.0f, 0.0f };
+        v[which] = r;
+        bool expect = r >= threshold;
+        bool got = (classify(v[0], v[1], v[2]) & label) != 0;
+        if (expect != got) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "ratio %.4f: expected %d", r, expect);
+            TEST_MESSAGE(msg);
+        }
+        TEST_ASSERT_EQUAL_INT(expect, got);
+    }
+}
+
+static void test_tremor_rule(void)
+{
+    check_rule(CLS_TREMOR, 0.10f, CLS_FEAT_TREM);
+}
+
+static void test_dyskinesia_rule(void)
+{
+    check_rule(CLS_DYSKINESIA, 0.10f, CLS_FEAT_DYSK);
+}
+
+static void test_walking_rule(void)
+{
+    check_rule(CLS_WALKING, 0.20f, CLS_FEAT_STEP);
+}
+
+// the band just above the threshold used to be missed by truncation
+static void test_just_above_threshold(void)
+{
+    TEST_ASSERT_EQUAL_INT(CLS_TREMOR, classify(0.105f, 0.0f, 0.0f));
+    TEST_ASSERT_EQUAL_INT(CLS_DYSKINESIA, classify(0.0f, 0.105f, 0.0f));
+    TEST_ASSERT_EQUAL_INT(CLS_WALKING, classify(0.0f, 0.0f, 0.205f));
+    TEST_ASSERT_EQUAL_INT(0, classify(0.099f, 0.099f, 0.199f));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tremor_rule);
+    RUN_TEST(test_dyskinesia_rule);
+    RUN_TEST(test_walking_rule);
+    RUN_TEST(test_just_above_threshold);
+    return UNITY_END();
+}
@@ -0,0 +1,203 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "detector.h"
+
+/*
+Whole pipeline on synthetic wrist motion: a linear or rotational tremor
+at f must show up at f (not rectified to 2f), land in the right band and
+raise the right flag; a wrist at rest must be stationary.
+*/
+
+#define SETTLE_WINDOWS  2
+#define TWO_PI_F        6.28318531f
+
+static Detector det;
+
+void setUp(void)
+{
+    detector_init(&det);
+}
+
+void tearDown(void) {}
+
+/*
+Feed whole windows of a roll about x at freq with peak rate amp (dps),
+gravity turning with the sensor. Returns the last window.
+*/
+static WindowResult run_roll(float freq, float amp)
+{
+    WindowResult r = {};
+    int windows = 0;
+    for (int i = 0; windows < SETTLE_WINDOWS + 1; i++) {
+        float t = (float)i / SAMPLE_RATE;
+        AccelData a = { 0.0f, 0.0f, 1.0f };
+        GyroData g = { 0.0f, 0.0f, 0.0f };
+        float roll = amp / (TWO_PI_F * freq) * sinf(TWO_PI_F * freq * t) * 0.01745329f;
+        g.gx = amp * cosf(TWO_PI_F * freq * t);
+        a.ay = sinf(roll);
+        a.az = cosf(roll);
+        if (detector_push(&det, a, g, &r)) {
+            windows++;
+        }
+    }
+    return r;
+}
+
+static void report(const char *what, const WindowResult *r)
+{
+    char msg[160];
+    const BandEnergy *e = &r->energy;
+    snprintf(msg, sizeof(msg), "%s: trem %.2f dysk %.2f step %.2f of total, flags %02x",
+             what, e->total > 0 ? e->trem / e->total : 0.0f,
+             e->total > 0 ? e->dysk / e->total : 0.0f,
+             e->total > 0 ? e->step / e->total : 0.0f, detector_flags(r));
+    TEST_MESSAGE(msg);
+}
+
+/*
+A pure linear tremor is below the stationary threshold of the fused
+signal (the gyro sets its scale), so check the fused signal's spectrum
+directly.
+*/
+static void test_linear_tremor_stays_at_f(void)
+{
+    float32_t window[WINDOW_SAMPLES];
+    for (int i = 0; i < (SETTLE_WINDOWS + 1) * WINDOW_SAMPLES; i++) {
+        float t = (float)i / SAMPLE_RATE;
+        AccelData a = { 0.3f * sinf(TWO_PI_F * 2.25f * t), 0.0f, 1.0f };
+        GyroData g = { 0.0f, 0.0f, 0.0f };
+        window[i % WINDOW_SAMPLES] = detector_fuse(&det, a, g);
+    }
+
+    static FftContext fft;
+    BandEnergy e;
+    TEST_ASSERT_TRUE(fft_compute(&fft, window, WINDOW_SAMPLES));
+    classifier_band_energy(&fft, &e);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "linear 2.25 Hz: trem %.2f dysk %.2f of total",
+             e.trem / e.total, e.dysk / e.total);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(e.trem > 0.5f * e.total);
+    TEST_ASSERT_TRUE(e.dysk < 0.1f * e.total);
+}
+
+static void test_rotational_tremor_stays_at_f(void)
+{
+    WindowResult r = run_roll(2.5f, 20.0f);
+    report("roll 2.5 Hz", &r);
+    TEST_ASSERT_FALSE(r.stationary);
+    TEST_ASSERT_TRUE(r.energy.trem > r.energy.dysk * 4.0f);
+    TEST_ASSERT_TRUE(r.energy.trem > 0.5f * r.energy.total);
+    TEST_ASSERT_EQUAL_INT(1, r.tremor_flag);
+}
+
+// 2.25 Hz rectified would land at 4.5 Hz, in the dyskinesia band
+static void test_tremor_is_not_reported_as_dyskinesia(void)
+{
+    WindowResult r = run_roll(2.25f, 20.0f);
+    report("roll 2.25 Hz", &r);
+    TEST_ASSERT_TRUE(r.energy.dysk < 0.1f * r.energy.total);
+    TEST_ASSERT_EQUAL_INT(1, r.tremor_flag);
+    TEST_ASSERT_EQUAL_INT(0, r.dyskinesia_flag);
+}
+
+static void test_dyskinesia_band(void)
+{
+    WindowResult r = run_roll(4.5f, 20.0f);
+    report("roll 4.5 Hz", &r);
+    TEST_ASSERT_TRUE(r.energy.dysk > r.energy.trem * 4.0f);
+    TEST_ASSERT_EQUAL_INT(1, r.dyskinesia_flag);
+    TEST_ASSERT_EQUAL_INT(0, r.tremor_flag);
+}
+
+// an offset in the window must not become the reported peak
+static void test_peak_ignores_offset(void)
+{
+    float32_t window[WINDOW_SAMPLES];
+    for (int i = 0; i < WINDOW_SAMPLES; i++) {
+        window[i] = 3.0f + 0.5f * sinf(TWO_PI_F * 2.6f * i / SAMPLE_RATE);
+    }
+    WindowResult r;
+    detector_process_window(&det, window, WINDOW_SAMPLES, &r);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.6f, r.peak.freq);
+    TEST_ASSERT_TRUE(r.energy.trem > 0.6f * r.energy.total);
+}
+
+// motion along a diagonal no sensor axis is aligned with, starting orthogonal to it
+static void test_dominant_axis_follows_motion(void)
+{
+    DominantAxisState st;
+    filter_dominant_axis_init(&st);
+    const float k = 0.70710678f;
+    float out = 0.0f;
+    for (int i = 0; i < 4 * SAMPLE_RATE; i++) {
+        float s = 0.2f * sinf(TWO_PI_F * 2.0f * i / SAMPLE_RATE);
+        out = filter_dominant_axis_project(&st, k * s, -k * s, 0.0f);
+        if (i == 4 * SAMPLE_RATE - 1) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, fabsf(s), fabsf(out));
+        }
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, fabsf(k * st.axis[0] - k * st.axis[1]));
+
+    // the sign stays put through a long pause
+    float before = st.axis[0];
+    for (int i = 0; i < 10 * SAMPLE_RATE; i++) {
+        filter_dominant_axis_project(&st, 0.0f, 0.0f, 0.0f);
+    }
+    TEST_ASSERT_TRUE(before * st.axis[0] > 0.0f);
+}
+
+static uint32_t rng_state = 12345;
+
+// zero-mean gaussian with standard deviation sd (Box-Muller on an LCG)
+static float noise(float sd)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    float u1 = ((rng_state >> 8) + 1) / 16777217.0f;
+    rng_state = rng_state * 1664525u + 1013904223u;
+    float u2 = (rng_state >> 8) / 16777216.0f;
+    return sd * sqrtf(-2.0f * logf(u1)) * cosf(TWO_PI_F * u2);
+}
+
+/*
+A tilted wrist at rest with sensor noise (0.004 g, 0.3 dps, as in the
+latency bench) and a gyro zero-rate offset: every window stationary,
+no flag raised.
+*/
+static void test_rest_is_stationary(void)
+{
+    const float tilt = 15.0f * 0.01745329f;
+    WindowResult r = {};
+    int windows = 0, moving = 0, flagged = 0;
+    float max_var = 0.0f;
+    for (int i = 0; windows < 20; i++) {
+        AccelData a = { noise(0.004f), sinf(tilt) + noise(0.004f), cosf(tilt) + noise(0.004f) };
+        GyroData g = { 1.5f + noise(0.3f), -0.8f + noise(0.3f), noise(0.3f) };
+        if (!detector_push(&det, a, g, &r)) continue;
+        if (++windows <= SETTLE_WINDOWS) continue;
+        if (!r.stationary) moving++;
+        if (r.tremor_flag || r.dyskinesia_flag || r.fog_flag || r.walking) flagged++;
+        if (r.variance > max_var) max_var = r.variance;
+    }
+    char msg[96];
+    snprintf(msg, sizeof(msg), "rest: max variance %.4f (threshold %.4f), %d moving, %d flagged",
+             max_var, STATIONARY_VAR, moving, flagged);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_INT(0, moving);
+    TEST_ASSERT_EQUAL_INT(0, flagged);
+    TEST_ASSERT_TRUE(max_var < 0.5f * STATIONARY_VAR);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_linear_tremor_stays_at_f);
+    RUN_TEST(test_rotational_tremor_stays_at_f);
+    RUN_TEST(test_tremor_is_not_reported_as_dyskinesia);
+    RUN_TEST(test_dyskinesia_band);
+    RUN_TEST(test_peak_ignores_offset);
+    RUN_TEST(test_dominant_axis_follows_motion);
+    RUN_TEST(test_rest_is_stationary);
+    return UNITY_END();
+}
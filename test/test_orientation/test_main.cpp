@@ -0,0 +1,182 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "orientation.h"
+#include "fft_analysis.h"
+
+/*
+Orientation filter against ground truth, same trace as
+tools/orientation_bench: continuous rotation about all three axes, a 90
+degree roll in one second at t = 30 s, a 4 Hz 0.1 g linear acceleration
+in the earth frame, sensor noise. Bounds are about twice what the bench
+reports (0.7 / 2.0 deg gravity error, 0.015 g linear RMS).
+*/
+
+#define DURATION_S  60.0f
+#define SETTLE_S    2.0f
+#define LIN_AMP_G   0.1f
+#define LIN_FREQ    4.0f
+
+typedef struct {
+    double w, x, y, z;
+} Quat;
+
+typedef struct {
+    double ang_mean, ang_max, lin_rms;
+} Errors;
+
+static OrientationState st;
+
+void setUp(void)
+{
+    orientation_init(&st);
+}
+
+void tearDown(void) {}
+
+static Quat quat_mul(Quat a, Quat b)
+{
+    Quat r;
+    r.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+    r.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+    r.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+    r.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+    return r;
+}
+
+// earth-frame vector into the sensor frame: q* v q
+static void earth_to_sensor(Quat q, const double v[3], double out[3])
+{
+    Quat p = { 0.0, v[0], v[1], v[2] };
+    Quat qc = { q.w, -q.x, -q.y, -q.z };
+    Quat r = quat_mul(quat_mul(qc, p), q);
+    out[0] = r.x;
+    out[1] = r.y;
+    out[2] = r.z;
+}
+
+// body rates (dps): slow wandering plus a 90 degree roll at t = 30..31 s
+static void body_rate(double t, double w[3])
+{
+    w[0] = 30.0 * sin(2.0 * M_PI * 0.2 * t);
+    w[1] = 20.0 * cos(2.0 * M_PI * 0.13 * t);
+    w[2] = 10.0;
+    if (t >= 30.0 && t < 31.0) {
+        w[0] += 90.0;
+    }
+}
+
+static double noise(unsigned *s)
+{
+    *s = *s * 1103515245u + 12345u;
+    return ((*s >> 8) & 0xFFFF) / 65535.0 - 0.5;
+}
+
+// start: initial true orientation, rotated about x by start_roll_deg
+static Errors run(double start_roll_deg)
+{
+    const double dt = 1.0 / SAMPLE_RATE;
+    const int n = (int)(DURATION_S * SAMPLE_RATE);
+    double h = 0.5 * start_roll_deg * M_PI / 180.0;
+    Quat q = { cos(h), sin(h), 0.0, 0.0 };
+    unsigned seed = 1;
+    double ang_sum = 0.0, lin_sq = 0.0;
+    Errors e = {};
+    int counted = 0;
+
+    for (int i = 0; i < n; i++) {
+        double t = i * dt;
+        double w[3];
+        body_rate(t, w);
+
+        double wx = w[0] * M_PI / 180.0, wy = w[1] * M_PI / 180.0, wz = w[2] * M_PI / 180.0;
+        double rate = sqrt(wx * wx + wy * wy + wz * wz);
+        double half = 0.5 * rate * dt;
+        double k = (rate > 0.0) ? sin(half) / rate : 0.5 * dt;
+        Quat dq = { cos(half), wx * k, wy * k, wz * k };
+        q = quat_mul(q, dq);
+
+        double lin_e[3] = { LIN_AMP_G * sin(2.0 * M_PI * LIN_FREQ * t), 0.0, 0.0 };
+        double spec_e[3] = { lin_e[0], lin_e[1], lin_e[2] + 1.0 };
+        double spec_s[3], lin_s[3], grav_s[3];
+        const double up[3] = { 0.0, 0.0, 1.0 };
+        earth_to_sensor(q, spec_e, spec_s);
+        earth_to_sensor(q, lin_e, lin_s);
+        earth_to_sensor(q, up, grav_s);
+
+        AccelData a;
+        GyroData g;
+        a.ax = (float)(spec_s[0] + 0.008 * noise(&seed));
+        a.ay = (float)(spec_s[1] + 0.008 * noise(&seed));
+        a.az = (float)(spec_s[2] + 0.008 * noise(&seed));
+        g.gx = (float)(w[0] + 0.5 * noise(&seed));
+        g.gy = (float)(w[1] + 0.5 * noise(&seed));
+        g.gz = (float)(w[2] + 0.5 * noise(&seed));
+
+        if (i == 0) {
+            orientation_init_from_accel(&st, a);
+        }
+        AccelData lin = orientation_update(&st, a, g, (float)dt);
+        if (t < SETTLE_S) {
+            continue;
+        }
+
+        AccelData ge = orientation_gravity(&st);
+        double dot = ge.ax * grav_s[0] + ge.ay * grav_s[1] + ge.az * grav_s[2];
+        if (dot > 1.0) dot = 1.0;
+        double ang = acos(dot) * 180.0 / M_PI;
+        ang_sum += ang;
+        if (ang > e.ang_max) e.ang_max = ang;
+
+        double ex = lin.ax - lin_s[0], ey = lin.ay - lin_s[1], ez = lin.az - lin_s[2];
+        lin_sq += ex * ex + ey * ey + ez * ez;
+        counted++;
+    }
+    e.ang_mean = ang_sum / counted;
+    e.lin_rms = sqrt(lin_sq / counted);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "start roll %.0f deg: gravity error mean %.2f max %.2f deg, linear RMS %.4f g",
+             start_roll_deg, e.ang_mean, e.ang_max, e.lin_rms);
+    TEST_MESSAGE(msg);
+    return e;
+}
+
+static void test_gravity_follows_rotation(void)
+{
+    Errors e = run(0.0);
+    TEST_ASSERT_TRUE(e.ang_mean < 1.5);
+    TEST_ASSERT_TRUE(e.ang_max < 4.0);
+}
+
+// the 0.1 g linear signal has 0.071 g RMS, the residual must stay well below it
+static void test_linear_accel_error(void)
+{
+    Errors e = run(0.0);
+    TEST_ASSERT_TRUE(e.lin_rms < 0.03);
+}
+
+// started upside down, the first accel sample sets the tilt
+static void test_init_from_first_sample(void)
+{
+    Errors e = run(170.0);
+    TEST_ASSERT_TRUE(e.ang_mean < 1.5);
+    TEST_ASSERT_TRUE(e.ang_max < 4.0);
+
+    AccelData a = { 0.0f, sinf(0.5f), cosf(0.5f) };
+    orientation_init(&st);
+    orientation_init_from_accel(&st, a);
+    AccelData g = orientation_gravity(&st);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, a.ax, g.ax);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, a.ay, g.ay);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, a.az, g.az);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_gravity_follows_rotation);
+    RUN_TEST(test_linear_accel_error);
+    RUN_TEST(test_init_from_first_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,110 @@
+#include <unity.h>
+#include "scratch_arena.h"
+
+/*
+Scratch arena lifetimes: LIFO reuse, detection of overlapping regions and
+recovery of the arena after an out-of-order release.
+*/
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_lifo_reuse(void)
+{
+    ScratchRegion a, b;
+    float32_t *pa = scratch_acquire(&a, 100, "a");
+    float32_t *pb = scratch_acquire(&b, 100, "b");
+    TEST_ASSERT_NOT_NULL(pa);
+    TEST_ASSERT_EQUAL_PTR(pa + 100, pb);
+
+    scratch_release(&b);
+    scratch_release(&a);
+    TEST_ASSERT_EQUAL_INT(-1, a.offset);
+
+    // everything is free again
+    ScratchRegion all;
+    TEST_ASSERT_EQUAL_PTR(pa, scratch_acquire(&all, SCRATCH_ARENA_FLOATS, "all"));
+    scratch_release(&all);
+}
+
+static void test_exhaustion(void)
+{
+    ScratchRegion a, b;
+    TEST_ASSERT_NOT_NULL(scratch_acquire(&a, SCRATCH_ARENA_FLOATS - 10, "a"));
+    TEST_ASSERT_NULL(scratch_acquire(&b, 11, "b"));
+    TEST_ASSERT_EQUAL_INT(-1, b.offset);
+    scratch_release(&b);     // failed acquire, release is a no-op
+    scratch_release(&a);
+    TEST_ASSERT_EQUAL_INT(SCRATCH_ARENA_FLOATS, scratch_high_water());
+}
+
+static void test_out_of_order_release_is_detected(void)
+{
+    int errors = scratch_overlap_errors();
+    ScratchRegion a, b, c;
+    float32_t *pa = scratch_acquire(&a, 100, "a");
+    scratch_acquire(&b, 100, "b");
+    float32_t *pc = scratch_acquire(&c, 100, "c");
+
+    // b ends while c (acquired later) is still live
+    scratch_release(&b);
+    TEST_ASSERT_EQUAL_INT(errors + 1, scratch_overlap_errors());
+
+    // b's memory must not be handed out while c still uses the space above it
+    ScratchRegion d;
+    float32_t *pd = scratch_acquire(&d, 50, "d");
+    TEST_ASSERT_TRUE(pd >= pc + 100);
+    scratch_release(&d);
+
+    // releasing c reclaims b as well, a stays live
+    scratch_release(&c);
+    ScratchRegion e;
+    TEST_ASSERT_EQUAL_PTR(pa + 100, scratch_acquire(&e, 10, "e"));
+    scratch_release(&e);
+
+    scratch_release(&a);
+    TEST_ASSERT_EQUAL_INT(errors + 1, scratch_overlap_errors());
+}
+
+static void test_arena_recovers_after_overlap(void)
+{
+    int errors = scratch_overlap_errors();
+    ScratchRegion outer, inner;
+    scratch_acquire(&outer, 200, "outer");
+    scratch_acquire(&inner, 200, "inner");
+
+    // outer released first, then inner: both orders must leave the arena empty
+    scratch_release(&outer);
+    scratch_release(&inner);
+    TEST_ASSERT_EQUAL_INT(errors + 1, scratch_overlap_errors());
+
+    ScratchRegion fft;
+    TEST_ASSERT_NOT_NULL(scratch_acquire(&fft, SCRATCH_ARENA_FLOATS, "fft"));
+    scratch_release(&fft);
+}
+
+static void test_double_release_is_detected(void)
+{
+    int errors = scratch_overlap_errors();
+    ScratchRegion a;
+    scratch_acquire(&a, 10, "a");
+    ScratchRegion copy = a;
+    scratch_release(&a);
+    scratch_release(&copy);    // stale handle to a region that is gone
+    TEST_ASSERT_EQUAL_INT(errors + 1, scratch_overlap_errors());
+
+    ScratchRegion all;
+    TEST_ASSERT_NOT_NULL(scratch_acquire(&all, SCRATCH_ARENA_FLOATS, "all"));
+    scratch_release(&all);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lifo_reuse);
+    RUN_TEST(test_exhaustion);
+    RUN_TEST(test_out_of_order_release_is_detected);
+    RUN_TEST(test_arena_recovers_after_overlap);
+    RUN_TEST(test_double_release_is_detected);
+    return UNITY_END();
+}
@@ -0,0 +1,414 @@
+#include <unity.h>
+#include <chrono>
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include "session_log.h"
+#include "flash_sim.h"
+
+/*
+Session log on a simulated NOR flash: power loss in the middle of a
+record, of a sector erase and of a sector header; ring wrap-around and
+wear levelling; range reads across sectors with equal timestamps; RTC
+restarts between mounts; prepare on another thread; append throughput.
+*/
+
+#define FLASH_FILE    "session_log_test.bin"
+#define SECTORS       8
+#define SECTOR_BYTES  4096
+
+void setUp(void)
+{
+    remove(FLASH_FILE);
+}
+
+void tearDown(void)
+{
+    remove(FLASH_FILE);
+}
+
+typedef struct {
+    std::vector<uint32_t> ids;       // WindowRecord.total_energy carries the id
+    std::vector<uint32_t> times;
+    std::vector<BootRecord> boots;
+} Collected;
+
+static bool collect(uint8_t type, uint32_t timestamp, const void *payload,
+                    uint16_t length, void *ctx)
+{
+    Collected *c = (Collected *)ctx;
+    if (type == SESSION_REC_WINDOW && length == sizeof(WindowRecord)) {
+        c->ids.push_back((uint32_t)((const WindowRecord *)payload)->total_energy);
+        c->times.push_back(timestamp);
+    } else if (type == SESSION_REC_BOOT && length == sizeof(BootRecord)) {
+        c->boots.push_back(*(const BootRecord *)payload);
+    }
+    return true;
+}
+
+static int append_window(uint32_t id, uint32_t ts)
+{
+    WindowRecord rec = {0};
+    rec.state = (uint8_t)(id % 4);
+    rec.total_energy = (float)id;
+    return session_log_append(SESSION_REC_WINDOW, ts, &rec, sizeof(rec));
+}
+
+static Collected read_all(void)
+{
+    Collected c;
+    session_log_read_range(0, 0xFFFFFFFEu, collect, &c);
+    return c;
+}
+
+// records fill one sector after roughly this many appends
+static const int PER_SECTOR = (SECTOR_BYTES - 64) / (12 + sizeof(WindowRecord));
+
+static void test_append_and_read_back(void)
+{
+    FlashSim flash(FLASH_FILE, SECTORS);
+    TEST_ASSERT_EQUAL_INT(0, session_log_init(&flash));
+
+    for (uint32_t i = 0; i < 300; i++) {
+        TEST_ASSERT_EQUAL_INT(0, append_window(i, 1000 + i));
+    }
+    Collected c = read_all();
+    TEST_ASSERT_EQUAL_INT(300, c.ids.size());
+    for (uint32_t i = 0; i < 300; i++) {
+        TEST_ASSERT_EQUAL_UINT32(i, c.ids[i]);
+    }
+
+    Collected part;
+    session_log_read_range(1100, 1149, collect, &part);
+    TEST_ASSERT_EQUAL_INT(50, part.ids.size());
+    TEST_ASSERT_EQUAL_UINT32(100, part.ids[0]);
+    TEST_ASSERT_EQUAL_INT(0, flash.violations());
+}
+
+static void test_equal_timestamps_across_sectors(void)
+{
+    FlashSim flash(FLASH_FILE, SECTORS);
+    session_log_init(&flash);
+
+    // several records per second, the same second spans a sector boundary
+    uint32_t id = 0;
+    for (int i = 0; i < PER_SECTOR - 5; i++) append_window(id++, 100);
+    for (int i = 0; i < 20; i++) append_window(id++, 200);
+    for (int i = 0; i < 10; i++) append_window(id++, 300);
+
+    Collected c;
+    session_log_read_range(200, 200, collect, &c);
+    TEST_ASSERT_EQUAL_INT(20, c.ids.size());
+    TEST_ASSERT_EQUAL_UINT32(PER_SECTOR - 5, c.ids[0]);
+}
+
+/*
+Cut power after every possible number of programmed bytes of one record,
+then remount: everything appended before must survive, the torn record
+must not show up, and the log must keep accepting appends.
+*/
+static void test_power_loss_mid_record(void)
+{
+    const int before = 40;
+    const int rec_bytes = 12 + sizeof(WindowRecord);
+
+    for (int cut = 0; cut <= rec_bytes; cut++) {
+        remove(FLASH_FILE);
+        {
+            FlashSim flash(FLASH_FILE, SECTORS);
+            session_log_init(&flash);
+            for (int i = 0; i < before; i++) append_window(i, 10 + i);
+            flash.cut_after(cut);
+            append_window(before, 10 + before);
+        }
+
+        FlashSim flash(FLASH_FILE, SECTORS);       // reboot
+        TEST_ASSERT_EQUAL_INT(0, session_log_init(&flash));
+        Collected c = read_all();
+        int expect = before + (cut == rec_bytes ? 1 : 0);
+        TEST_ASSERT_EQUAL_INT(expect, c.ids.size());
+
+        TEST_ASSERT_EQUAL_INT(0, append_window(1000, 100));
+        c = read_all();
+        TEST_ASSERT_EQUAL_INT(expect + 1, c.ids.size());
+        TEST_ASSERT_EQUAL_UINT32(1000, c.ids.back());
+        TEST_ASSERT_EQUAL_INT(0, flash.violations());
+    }
+}
+
+/*
+Same for the append that opens a new sector with an inline erase: the cut
+lands in the erase, in the header halves or in the first record.
+*/
+static void test_power_loss_mid_open_sector(void)
+{
+    const int budget_max = 1 + 8 + 16 + 2 * (12 + sizeof(WindowRecord)) + 2;
+
+    for (int cut = 0; cut <= budget_max; cut++) {
+        remove(FLASH_FILE);
+        int committed = 0;
+        {
+            FlashSim flash(FLASH_FILE, SECTORS);
+            session_log_init(&flash);
+            // fill sector 0 so the next append must open sector 1
+            while (true) {
+                SessionLogStats st;
+                session_log_get_stats(&st);
+                if (st.head_offset + 12 + sizeof(WindowRecord) > SECTOR_BYTES) break;
+                append_window(committed, 10 + committed);
+                committed++;
+            }
+            flash.cut_after(cut);
+            if (append_window(committed, 10 + committed) == 0 && !flash.dead()) {
+                committed++;
+            }
+        }
+
+        FlashSim flash(FLASH_FILE, SECTORS);
+        TEST_ASSERT_EQUAL_INT(0, session_log_init(&flash));
+        Collected c = read_all();
+        TEST_ASSERT_TRUE(c.ids.size() == (size_t)committed || c.ids.size() == (size_t)committed + 1);
+        for (size_t i = 0; i < c.ids.size(); i++) {
+            TEST_ASSERT_EQUAL_UINT32(i, c.ids[i]);
+        }
+
+        TEST_ASSERT_EQUAL_INT(0, append_window(5000, 5000));
+        TEST_ASSERT_EQUAL_INT(0, append_window(5001, 5001));
+        c = read_all();
+        TEST_ASSERT_EQUAL_UINT32(5001, c.ids.back());
+        TEST_ASSERT_EQUAL_UINT32(5000, c.ids[c.ids.size() - 2]);
+        TEST_ASSERT_EQUAL_INT(0, flash.violations());
+    }
+}
+
+// a prepare cut short leaves the sector unusable, the next open erases it again
+static void test_power_loss_mid_prepare(void)
+{
+    for (int cut = 0; cut <= 9; cut++) {
+        remove(FLASH_FILE);
+        {
+            FlashSim flash(FLASH_FILE, SECTORS);
+            session_log_init(&flash);
+            for (int i = 0; i < 10; i++) append_window(i, i);
+            flash.cut_after(cut);
+            session_log_prepare();
+        }
+
+        FlashSim flash(FLASH_FILE, SECTORS);
+        TEST_ASSERT_EQUAL_INT(0, session_log_init(&flash));
+        for (int i = 10; i < 3 * PER_SECTOR; i++) {
+            TEST_ASSERT_EQUAL_INT(0, append_window(i, i));
+        }
+        Collected c = read_all();
+        TEST_ASSERT_EQUAL_INT(3 * PER_SECTOR, c.ids.size());
+        TEST_ASSERT_EQUAL_INT(0, flash.violations());
+    }
+}
+
+static void test_prepare_keeps_erase_out_of_append(void)
+{
+    FlashSim flash(FLASH_FILE, SECTORS);
+    session_log_init(&flash);
+    session_log_prepare();
+
+    for (int i = 0; i < 5 * PER_SECTOR; i++) {
+        unsigned long erases = flash.erase_ops();
+        TEST_ASSERT_EQUAL_INT(0, append_window(i, i));
+        TEST_ASSERT_EQUAL_INT(erases, flash.erase_ops());
+        session_log_prepare();
+    }
+
+    SessionLogStats st;
+    session_log_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT32(0, st.sync_erases);
+    TEST_ASSERT_TRUE(st.next_prepared);
+
+    // a prepared sector survives a reboot and is still used
+    FlashSim again(FLASH_FILE, SECTORS);
+    session_log_init(&again);
+    session_log_get_stats(&st);
+    TEST_ASSERT_TRUE(st.next_prepared);
+}
+
+static void test_ring_wrap_levels_wear(void)
+{
+    FlashSim flash(FLASH_FILE, SECTORS);
+    session_log_init(&flash);
+
+    const int total = 10 * SECTORS * PER_SECTOR;
+    for (int i = 0; i < total; i++) {
+        TEST_ASSERT_EQUAL_INT(0, append_window(i, i / 4));
+        if (i % 16 == 0) session_log_prepare();
+    }
+
+    SessionLogStats st;
+    session_log_get_stats(&st);
+    TEST_ASSERT_LESS_OR_EQUAL(1, st.max_erase - st.min_erase);
+    TEST_ASSERT_GREATER_THAN(8, st.min_erase);
+    unsigned lo = flash.erases(0), hi = flash.erases(0);
+    for (int s = 1; s < SECTORS; s++) {
+        if (flash.erases(s) < lo) lo = flash.erases(s);
+        if (flash.erases(s) > hi) hi = flash.erases(s);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(1, hi - lo);
+
+    // the newest records survive, contiguous and in order
+    Collected c = read_all();
+    TEST_ASSERT_GREATER_THAN(4 * PER_SECTOR, c.ids.size());
+    TEST_ASSERT_EQUAL_UINT32(total - 1, c.ids.back());
+    for (size_t i = 1; i < c.ids.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(c.ids[i - 1] + 1, c.ids[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, flash.violations());
+}
+
+static void test_rtc_restart_between_mounts(void)
+{
+    {
+        FlashSim flash(FLASH_FILE, SECTORS);
+        session_log_init(&flash);
+        for (int i = 0; i < 100; i++) append_window(i, 1000000 + i);
+    }
+
+    // reboot with the RTC back at zero
+    FlashSim flash(FLASH_FILE, SECTORS);
+    session_log_init(&flash);
+    for (int i = 0; i < 100; i++) append_window(100 + i, 5 + i);
+
+    Collected c = read_all();
+    TEST_ASSERT_EQUAL_INT(200, c.ids.size());
+    TEST_ASSERT_EQUAL_INT(2, c.boots.size());
+    TEST_ASSERT_EQUAL_UINT32(1, c.boots[0].boot);
+    TEST_ASSERT_EQUAL_UINT32(2, c.boots[1].boot);
+    TEST_ASSERT_EQUAL_UINT32(5, c.boots[1].rtc_time);
+
+    // second session keeps its spacing after the first one instead of piling up
+    TEST_ASSERT_EQUAL_UINT32(1000099, c.times[100]);
+    TEST_ASSERT_EQUAL_UINT32(1000099 + 99, c.times[199]);
+    for (size_t i = 1; i < c.times.size(); i++) {
+        TEST_ASSERT_TRUE(c.times[i] >= c.times[i - 1]);
+    }
+
+    Collected later;
+    session_log_read_range(1000150, 1000160, collect, &later);
+    TEST_ASSERT_EQUAL_INT(11, later.ids.size());
+    TEST_ASSERT_EQUAL_UINT32(151, later.ids[0]);
+
+    // a third mount that logs nothing but a boot record still gets a new number
+    {
+        FlashSim f3(FLASH_FILE, SECTORS);
+        session_log_init(&f3);
+        SessionLogStats st;
+        session_log_get_stats(&st);
+        TEST_ASSERT_EQUAL_UINT32(3, st.boot);
+        append_window(999, 0);
+    }
+    FlashSim f4(FLASH_FILE, SECTORS);
+    session_log_init(&f4);
+    SessionLogStats st;
+    session_log_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT32(4, st.boot);
+}
+
+// erases take as long as on the chip, so appends land in the middle of them
+class SlowFlash : public FlashSim {
+public:
+    SlowFlash(const char *path, bd_size_t sectors) : FlashSim(path, sectors) {}
+
+    int erase(bd_addr_t addr, bd_size_t size)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return FlashSim::erase(addr, size);
+    }
+};
+
+/*
+session_log_prepare() looping on a second thread, as the log thread in
+main.cpp does: every append either lands or is counted as dropped, the
+log reads back complete and in order, and no erase runs inside append.
+*/
+static void test_prepare_on_another_thread(void)
+{
+    SlowFlash flash(FLASH_FILE, SECTORS);
+    session_log_init(&flash);
+    session_log_prepare();
+
+    std::atomic<bool> stop(false);
+    std::thread preparer([&stop] {
+        while (!stop) {
+            session_log_prepare();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    const int total = 3 * SECTORS * PER_SECTOR;
+    std::vector<uint32_t> stored;
+    for (int i = 0; i < total; i++) {
+        if (append_window(i, i) == 0) stored.push_back(i);
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    stop = true;
+    preparer.join();
+
+    SessionLogStats st;
+    session_log_get_stats(&st);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%d appends: %u stored, %u dropped, %u inline erases",
+             total, (unsigned)stored.size(), (unsigned)st.dropped, (unsigned)st.sync_erases);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_INT(total, stored.size() + st.dropped);
+    TEST_ASSERT_GREATER_THAN(0, st.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, st.sync_erases);
+    TEST_ASSERT_EQUAL_INT(0, flash.violations());
+
+    // the ring keeps the newest records, exactly the stored ones
+    Collected c = read_all();
+    TEST_ASSERT_GREATER_THAN(0, c.ids.size());
+    size_t skip = stored.size() - c.ids.size();
+    for (size_t i = 0; i < c.ids.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(stored[skip + i], c.ids[i]);
+    }
+}
+
+static void test_append_throughput(void)
+{
+    FlashSim flash(FLASH_FILE, 64);
+    session_log_init(&flash);
+    session_log_prepare();
+
+    const int n = 20000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        append_window(i, i / 10);
+        if (i % 64 == 0) session_log_prepare();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%d appends in %.3f s: %.0f appends/s, %.1f KB/s to the simulator",
+             n, sec, n / sec, flash.program_bytes() / 1024.0 / sec);
+    TEST_MESSAGE(msg);
+
+    // one window record every 3 s is the device load; keep a wide margin
+    TEST_ASSERT_GREATER_THAN(1000.0, n / sec);
+    SessionLogStats st;
+    session_log_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT32(0, st.sync_erases);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_append_and_read_back);
+    RUN_TEST(test_equal_timestamps_across_sectors);
+    RUN_TEST(test_power_loss_mid_record);
+    RUN_TEST(test_power_loss_mid_open_sector);
+    RUN_TEST(test_power_loss_mid_prepare);
+    RUN_TEST(test_prepare_keeps_erase_out_of_append);
+    RUN_TEST(test_ring_wrap_levels_wear);
+    RUN_TEST(test_rtc_restart_between_mounts);
+    RUN_TEST(test_prepare_on_another_thread);
+    RUN_TEST(test_append_throughput);
+    return UNITY_END();
+}
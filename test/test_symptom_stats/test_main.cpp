@@ -0,0 +1,201 @@
+#include <unity.h>
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+#include "symptom_stats.h"
+
+/*
+Per-hour and per-minute summaries against exact values: percentiles from
+the sorted ratios (error at most the width of the histogram bin plus one
+1/255 step) and duty fractions from the flag counts (one 1/255 step).
+*/
+
+#define WINDOW_SEC   3
+
+static const float LSB = 1.0f / 255.0f;
+
+void setUp(void)
+{
+    symptom_stats_init();
+}
+
+void tearDown(void) {}
+
+static uint32_t rng_state = 12345;
+
+static float uniform(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) / 16777216.0f;
+}
+
+static float exact_percentile(std::vector<float> v, float q)
+{
+    std::sort(v.begin(), v.end());
+    return v[(size_t)(q * (v.size() - 1) + 0.5f)];
+}
+
+static float decode_ratio(uint8_t v)
+{
+    return v / 255.0f;
+}
+
+// error bound for a percentile whose exact value is x
+static float pct_tol(float x)
+{
+    const float *edges = stats_ratio_edges();
+    for (int i = 0; i < STATS_RATIO_BINS; i++) {
+        if (x < edges[i + 1] || i == STATS_RATIO_BINS - 1) {
+            return edges[i + 1] - edges[i] + LSB;
+        }
+    }
+    return 1.0f;
+}
+
+static void assert_percentile(const std::vector<float> &v, float q, uint8_t got)
+{
+    float exact = exact_percentile(v, q);
+    TEST_ASSERT_FLOAT_WITHIN(pct_tol(exact), exact, decode_ratio(got));
+}
+
+typedef struct {
+    std::vector<float> trem, dysk;
+    int windows, tremor, dysk_n, stationary, walking, fog;
+} Exact;
+
+// one hour of windows; ratios drawn around the given centres
+static Exact feed_hour(uint32_t hour, float trem_centre, float dysk_centre)
+{
+    Exact ex = {};
+    for (uint32_t t = hour * 3600; t < (hour + 1) * 3600; t += WINDOW_SEC) {
+        uint8_t flags = 0;
+        float trem = -1.0f, dysk = -1.0f;
+        if (uniform() < 0.2f) {
+            flags |= STATS_STATIONARY;
+            ex.stationary++;
+        } else {
+            trem = trem_centre * (0.5f + uniform());
+            dysk = dysk_centre * (0.5f + uniform());
+            ex.trem.push_back(trem);
+            ex.dysk.push_back(dysk);
+            if (trem > 0.10f) { flags |= STATS_TREMOR; ex.tremor++; }
+            if (dysk > 0.10f) { flags |= STATS_DYSKINESIA; ex.dysk_n++; }
+            if (uniform() < 0.3f) { flags |= STATS_WALKING; ex.walking++; }
+            if (uniform() < 0.01f) { flags |= STATS_FOG; ex.fog++; }
+        }
+        symptom_stats_add(t, flags, trem, dysk);
+        ex.windows++;
+    }
+    return ex;
+}
+
+static void check_hour(const HourSummary *h, const Exact &ex, uint32_t hour)
+{
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "hour %u: trem p50 %.3f/%.3f p90 %.3f/%.3f, dysk p50 %.3f/%.3f p90 %.3f/%.3f",
+             (unsigned)hour,
+             decode_ratio(h->trem_p50), exact_percentile(ex.trem, 0.5f),
+             decode_ratio(h->trem_p90), exact_percentile(ex.trem, 0.9f),
+             decode_ratio(h->dysk_p50), exact_percentile(ex.dysk, 0.5f),
+             decode_ratio(h->dysk_p90), exact_percentile(ex.dysk, 0.9f));
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL_UINT32(hour * 3600, h->start_ts);
+    TEST_ASSERT_EQUAL_INT(ex.windows, h->windows);
+    assert_percentile(ex.trem, 0.5f, h->trem_p50);
+    assert_percentile(ex.trem, 0.9f, h->trem_p90);
+    assert_percentile(ex.dysk, 0.5f, h->dysk_p50);
+    assert_percentile(ex.dysk, 0.9f, h->dysk_p90);
+
+    TEST_ASSERT_FLOAT_WITHIN(LSB, (float)ex.tremor / ex.windows, h->tremor_duty / 255.0f);
+    TEST_ASSERT_FLOAT_WITHIN(LSB, (float)ex.dysk_n / ex.windows, h->dysk_duty / 255.0f);
+    TEST_ASSERT_FLOAT_WITHIN(LSB, (float)ex.stationary / ex.windows, h->stationary_duty / 255.0f);
+    TEST_ASSERT_FLOAT_WITHIN(LSB, (float)ex.walking / ex.windows, h->walking_duty / 255.0f);
+    TEST_ASSERT_EQUAL_INT(ex.fog, h->fog_events);
+}
+
+static void test_hour_summaries_match_exact(void)
+{
+    // centres around the 0.10 / 0.20 thresholds, and one low-symptom hour
+    Exact h0 = feed_hour(0, 0.10f, 0.20f);
+    Exact h1 = feed_hour(1, 0.03f, 0.12f);
+    Exact h2 = feed_hour(2, 0.25f, 0.06f);
+    symptom_stats_add(3 * 3600, 0, -1.0f, -1.0f);    // closes hour 2
+
+    const HourSummary *hours = symptom_stats_hours();
+    check_hour(&hours[0], h0, 0);
+    check_hour(&hours[1], h1, 1);
+    check_hour(&hours[2], h2, 2);
+}
+
+static void test_minute_summaries_match_exact(void)
+{
+    std::vector<float> trem;
+    int windows = 0, tremor = 0;
+    for (uint32_t t = 0; t < 60; t += WINDOW_SEC) {
+        float r = 0.08f + 0.04f * uniform();
+        trem.push_back(r);
+        uint8_t flags = (r > 0.10f) ? STATS_TREMOR : 0;
+        if (flags) tremor++;
+        windows++;
+        TEST_ASSERT_FALSE(symptom_stats_add(t, flags, r, 0.0f));
+    }
+    TEST_ASSERT_TRUE(symptom_stats_add(60, 0, -1.0f, -1.0f));
+
+    const MinuteSummary *m = &symptom_stats_minutes()[0];
+    TEST_ASSERT_EQUAL_INT(0, m->minute_id);
+    TEST_ASSERT_EQUAL_INT(windows, m->windows);
+    TEST_ASSERT_EQUAL_INT(tremor, m->tremor);
+    assert_percentile(trem, 0.5f, m->trem_p50);
+}
+
+// 0.10 and 0.12 must not collapse into the same reported median
+static void test_threshold_resolution(void)
+{
+    for (uint32_t t = 0; t < 3600; t += WINDOW_SEC) {
+        symptom_stats_add(t, 0, 0.10f, 0.12f);
+    }
+    symptom_stats_add(3600, 0, -1.0f, -1.0f);
+
+    const HourSummary *h = &symptom_stats_hours()[0];
+    TEST_ASSERT_FLOAT_WITHIN(0.02f + LSB, 0.10f, decode_ratio(h->trem_p50));
+    TEST_ASSERT_FLOAT_WITHIN(0.02f + LSB, 0.12f, decode_ratio(h->dysk_p50));
+    TEST_ASSERT_TRUE(h->trem_p50 < h->dysk_p50);
+}
+
+// percentiles of ratios on one side of a threshold stay on that side (up to rounding)
+static void test_threshold_is_a_bin_edge(void)
+{
+    for (uint32_t t = 0; t < 3600; t += WINDOW_SEC) {
+        symptom_stats_add(t, 0, 0.08f + 0.0199f * uniform(), 0.20f + 0.0199f * uniform());
+    }
+    symptom_stats_add(3600, 0, -1.0f, -1.0f);
+
+    const HourSummary *h = &symptom_stats_hours()[0];
+    TEST_ASSERT_LESS_OR_EQUAL((int)(0.10f * 255.0f + 0.5f), h->trem_p90);
+    TEST_ASSERT_GREATER_THAN((int)(0.20f * 255.0f) - 1, h->dysk_p50);
+}
+
+static void test_high_ratios_keep_their_range(void)
+{
+    for (uint32_t t = 0; t < 3600; t += WINDOW_SEC) {
+        symptom_stats_add(t, 0, 0.6f + 0.1f * uniform(), 0.95f);
+    }
+    symptom_stats_add(3600, 0, -1.0f, -1.0f);
+
+    const HourSummary *h = &symptom_stats_hours()[0];
+    TEST_ASSERT_TRUE(decode_ratio(h->trem_p50) >= 0.50f && decode_ratio(h->trem_p90) < 0.75f + LSB);
+    TEST_ASSERT_TRUE(decode_ratio(h->dysk_p50) >= 0.75f);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_hour_summaries_match_exact);
+    RUN_TEST(test_minute_summaries_match_exact);
+    RUN_TEST(test_threshold_resolution);
+    RUN_TEST(test_threshold_is_a_bin_edge);
+    RUN_TEST(test_high_ratios_keep_their_range);
+    return UNITY_END();
+}
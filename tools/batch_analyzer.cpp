@@ -0,0 +1,234 @@
+/*
+Batch analyzer: run the on-device detection pipeline over many recordings.
+
+Every trace file is a CSV of raw IMU samples at SAMPLE_RATE, one sample per
+line (a header line is skipped):
+
+    ax,ay,az,gx,gy,gz          (g, dps)
+
+Files are processed concurrently by a work-stealing thread pool: each worker
+owns a deque of files, pops from its back and steals from the front of the
+others when it runs dry. One file is always processed start to end by one
+thread with its own Detector.
+
+Output is one tab-separated row per window, one column per field:
+
+    file  window  t_sec  state  tremor  dysk  fog  walking  stationary
+    variance  trem_ratio  dysk_ratio  step_ratio
+
+Throughput (samples/second) goes to stderr.
+
+Build (CMSIS-DSP sources from lib/CMSIS-DSP-main):
+    g++ -O2 -std=c++17 -DHOST_BUILD -Iinclude -Ilib/CMSIS-DSP-main/Include \
+        tools/batch_analyzer.cpp src/detector.cpp src/fft_analysis.cpp \
+        src/filter.cpp src/classifier.cpp src/scratch_arena.cpp \
+        src/orientation.cpp src/zoom_fft.cpp \
+        <CMSIS-DSP TransformFunctions/ComplexMathFunctions/CommonTables> \
+        -lpthread -o batch_analyzer
+
+    ./batch_analyzer -j 8 -o labels.tsv p01.csv p02.csv ...
+*/
+#include "detector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+struct WindowRow {
+    int window;
+    WindowResult result;
+};
+
+struct FileJob {
+    std::string path;
+    long size;
+    long samples;
+    bool ok;
+    std::vector<WindowRow> rows;
+};
+
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<size_t> jobs;
+};
+
+static bool read_sample(FILE *f, AccelData *accel, GyroData *gyro)
+{
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%f,%f,%f,%f,%f,%f",
+                   &accel->ax, &accel->ay, &accel->az,
+                   &gyro->gx, &gyro->gy, &gyro->gz) == 6) {
+            return true;
+        }
+        // header or malformed line: skip
+    }
+    return false;
+}
+
+// Same loop as main.cpp, minus BLE / flash
+static void analyze_file(FileJob *job)
+{
+    FILE *f = fopen(job->path.c_str(), "r");
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", job->path.c_str());
+        job->ok = false;
+        return;
+    }
+
+    Detector detector;
+    AccelData accel;
+    GyroData gyro;
+    WindowRow row;
+
+    detector_init(&detector);
+
+    while (read_sample(f, &accel, &gyro)) {
+        job->samples++;
+        if (detector_push(&detector, accel, gyro, &row.result)) {
+            row.window = (int)job->rows.size();
+            job->rows.push_back(row);
+        }
+    }
+
+    fclose(f);
+    job->ok = true;
+}
+
+static bool take_job(std::vector<WorkQueue> &queues, size_t self, size_t *job)
+{
+    {
+        WorkQueue &own = queues[self];
+        std::lock_guard<std::mutex> g(own.lock);
+        if (!own.jobs.empty()) {
+            *job = own.jobs.back();
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+
+    // steal the oldest (largest) job of another worker
+    for (size_t k = 1; k < queues.size(); k++) {
+        WorkQueue &victim = queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> g(victim.lock);
+        if (!victim.jobs.empty()) {
+            *job = victim.jobs.front();
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+static void write_rows(FILE *out, const std::vector<FileJob> &jobs)
+{
+    fprintf(out, "file\twindow\tt_sec\tstate\ttremor\tdysk\tfog\twalking\tstationary\t"
+                 "variance\ttrem_ratio\tdysk_ratio\tstep_ratio\n");
+
+    for (const FileJob &job : jobs) {
+        for (const WindowRow &row : job.rows) {
+            const WindowResult &r = row.result;
+            float inv = (r.energy.total > 0.0f) ? 1.0f / r.energy.total : 0.0f;
+            fprintf(out, "%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%.5f\t%.4f\t%.4f\t%.4f\n",
+                    job.path.c_str(), row.window, row.window * WINDOW_SEC,
+                    r.state, r.tremor_flag, r.dyskinesia_flag, r.fog_flag,
+                    r.walking ? 1 : 0, r.stationary ? 1 : 0, r.variance,
+                    r.energy.trem * inv, r.energy.dysk * inv, r.energy.step * inv);
+        }
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: batch_analyzer [-j threads] [-o out.tsv] trace.csv...\n");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    const char *out_path = NULL;
+    std::vector<FileJob> jobs;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            struct stat st;
+            FileJob job;
+            job.path = argv[i];
+            job.size = (stat(argv[i], &st) == 0) ? (long)st.st_size : 0;
+            job.samples = 0;
+            job.ok = false;
+            jobs.push_back(job);
+        }
+    }
+    if (jobs.empty()) {
+        usage();
+        return 1;
+    }
+    if (threads == 0) threads = 1;
+    if (threads > jobs.size()) threads = (unsigned)jobs.size();
+
+    // deal files largest first, round robin, so queues start balanced
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return jobs[a].size > jobs[b].size; });
+
+    std::vector<WorkQueue> queues(threads);
+    for (size_t i = 0; i < order.size(); i++) {
+        queues[i % threads].jobs.push_back(order[i]);
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> pool;
+    for (unsigned w = 0; w < threads; w++) {
+        pool.emplace_back([&, w]() {
+            size_t job;
+            while (take_job(queues, w, &job)) {
+                analyze_file(&jobs[job]);
+            }
+        });
+    }
+    for (std::thread &t : pool) t.join();
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    long samples = 0;
+    long windows = 0;
+    int failed = 0;
+    for (const FileJob &job : jobs) {
+        samples += job.samples;
+        windows += (long)job.rows.size();
+        if (!job.ok) failed++;
+    }
+
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (out == NULL) {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return 1;
+    }
+    write_rows(out, jobs);
+    if (out != stdout) fclose(out);
+
+    fprintf(stderr, "%zu files (%d failed), %ld windows, %ld samples in %.3f s "
+                    "on %u threads: %.0f samples/s (%.0fx real time)\n",
+            jobs.size(), failed, windows, samples, sec, threads,
+            sec > 0 ? samples / sec : 0.0,
+            sec > 0 ? samples / sec / SAMPLE_RATE : 0.0);
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,506 @@
+/*
+Gateway: run one detector per wearable for many wearables at once.
+
+Each stream is a sequence of raw IMU samples in the same CSV format as
+tools/batch_analyzer.cpp (ax,ay,az,gx,gy,gz per line). Streams come from
+trace files or from clients of a Unix domain socket (stand-ins for BLE
+links), and every stream owns an independent Detector.
+
+One reader thread polls all sources and parses samples into a fixed-size
+ring per stream; when the ring is full the source is not read any more
+(back pressure), so memory per stream is bounded by sizeof(Stream).
+A stream is freed once its input has ended and its last samples have
+been processed, so --max-streams limits live connections, not the total.
+A fixed pool of workers takes ready streams from a queue and runs up to
+one window of samples per turn, so a busy stream cannot starve the others
+and a stream is never processed by two workers at the same time.
+
+Window results go to stdout, one tab-separated row per window:
+
+    stream  window  state  tremor  dysk  fog  walking  stationary
+
+Load test: --load N runs N synthetic 52 Hz streams from memory for a few
+seconds and reports how many real-time streams each core sustains.
+
+Build like batch_analyzer:
+    g++ -O2 -std=c++17 -DHOST_BUILD -Iinclude -Ilib/CMSIS-DSP-main/Include \
+        tools/gateway.cpp src/detector.cpp src/fft_analysis.cpp \
+        src/filter.cpp src/classifier.cpp src/scratch_arena.cpp \
+        src/orientation.cpp src/zoom_fft.cpp <CMSIS-DSP sources> -lpthread -o gateway
+
+    ./gateway -j 4 ward3_bed1.csv ward3_bed2.csv
+    ./gateway -j 4 --listen /tmp/pd_gateway.sock
+    ./gateway -j 1 --load 500 --seconds 5
+*/
+#include "detector.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define RING_SAMPLES     (2 * WINDOW_SAMPLES)   // input backlog per stream
+#define QUANTUM          WINDOW_SAMPLES         // samples per worker turn
+#define PENDING_BYTES    1024                   // unparsed input per stream
+#define MAX_LINE         128
+
+typedef struct {
+    AccelData accel;
+    GyroData gyro;
+} Sample;
+
+struct Stream {
+    int id;
+    int fd;                     // -1 for synthetic streams
+    std::string name;
+
+    Detector det;               // touched only by the worker holding the stream
+    long windows;
+    long samples;
+
+    // input ring, shared between reader and worker
+    std::mutex lock;
+    Sample ring[RING_SAMPLES];
+    int ring_head;
+    int ring_count;
+    bool scheduled;             // queued or being processed
+    bool eof;
+    bool done;
+
+    // parse state, owned by the reader (pending_len under lock)
+    char pending[PENDING_BYTES];
+    int pending_len;
+    char line[MAX_LINE];
+    int line_len;
+    int synth_pos;              // synthetic streams: offset in synth_table
+};
+
+// live streams only; finished ones are folded into the totals and freed
+static std::vector<std::unique_ptr<Stream>> streams;
+static int next_stream_id = 0;
+static long finished_streams = 0;
+static long finished_samples = 0;
+static long finished_windows = 0;
+
+static std::mutex queue_lock;
+static std::condition_variable queue_cv;
+static std::deque<Stream *> ready;
+static bool stopping = false;
+
+static std::mutex out_lock;
+static bool quiet = false;
+
+// ---- synthetic load ----------------------------------------------------
+
+#define SYNTH_SECONDS  30
+#define SYNTH_SAMPLES  (SYNTH_SECONDS * SAMPLE_RATE)
+static Sample synth_table[SYNTH_SAMPLES];
+
+// 10 s tremor, 10 s walking, 10 s still: exercises every pipeline branch
+static void synth_init(void)
+{
+    for (int i = 0; i < SYNTH_SAMPLES; i++) {
+        float t = (float)i / SAMPLE_RATE;
+        float a = 0.0f;
+        if (t < 10.0f) {
+            a = 0.2f * sinf(2.0f * (float)M_PI * 2.5f * t);
+        } else if (t < 20.0f) {
+            a = 0.4f * sinf(2.0f * (float)M_PI * 1.8f * t);
+        }
+        Sample *s = &synth_table[i];
+        s->accel.ax = a;
+        s->accel.ay = 0.0f;
+        s->accel.az = 1.0f + a;
+        s->gyro.gx = 30.0f * a;
+        s->gyro.gy = 0.0f;
+        s->gyro.gz = 0.0f;
+    }
+}
+
+// ---- scheduling ----------------------------------------------------------
+
+// caller holds s->lock
+static void schedule_locked(Stream *s)
+{
+    if (s->scheduled) {
+        return;
+    }
+    s->scheduled = true;
+    std::lock_guard<std::mutex> g(queue_lock);
+    ready.push_back(s);
+    queue_cv.notify_one();
+}
+
+static void emit(Stream *s, const WindowResult *r)
+{
+    s->windows++;
+    if (quiet) {
+        return;
+    }
+    std::lock_guard<std::mutex> g(out_lock);
+    printf("%s\t%ld\t%d\t%d\t%d\t%d\t%d\t%d\n", s->name.c_str(), s->windows - 1,
+           r->state, r->tremor_flag, r->dyskinesia_flag, r->fog_flag,
+           r->walking ? 1 : 0, r->stationary ? 1 : 0);
+}
+
+// one worker turn: up to QUANTUM samples of one stream
+static void run_stream(Stream *s)
+{
+    Sample batch[QUANTUM];
+    int n = 0;
+    WindowResult r;
+
+    if (s->fd < 0) {
+        // synthetic: always ready, read straight from the table
+        for (n = 0; n < QUANTUM; n++) {
+            batch[n] = synth_table[s->synth_pos];
+            s->synth_pos = (s->synth_pos + 1) % SYNTH_SAMPLES;
+        }
+    } else {
+        std::lock_guard<std::mutex> g(s->lock);
+        while (n < QUANTUM && s->ring_count > 0) {
+            batch[n++] = s->ring[s->ring_head];
+            s->ring_head = (s->ring_head + 1) % RING_SAMPLES;
+            s->ring_count--;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (detector_push(&s->det, batch[i].accel, batch[i].gyro, &r)) {
+            emit(s, &r);
+        }
+    }
+    s->samples += n;
+
+    std::lock_guard<std::mutex> g(s->lock);
+    s->scheduled = false;
+    if (s->fd < 0 || s->ring_count > 0) {
+        schedule_locked(s);
+    } else if (s->eof && s->pending_len == 0) {
+        s->done = true;
+    }
+}
+
+static void worker(void)
+{
+    while (true) {
+        Stream *s;
+        {
+            std::unique_lock<std::mutex> g(queue_lock);
+            queue_cv.wait(g, [] { return stopping || !ready.empty(); });
+            if (stopping) {
+                return;
+            }
+            s = ready.front();
+            ready.pop_front();
+        }
+        run_stream(s);
+    }
+}
+
+// ---- input ----------------------------------------------------------------
+
+static Stream *add_stream(int fd, const std::string &name)
+{
+    std::unique_ptr<Stream> s(new Stream());
+    s->id = next_stream_id++;
+    s->fd = fd;
+    s->name = name;
+    s->windows = 0;
+    s->samples = 0;
+    s->ring_head = 0;
+    s->ring_count = 0;
+    s->scheduled = false;
+    s->eof = false;
+    s->done = false;
+    s->pending_len = 0;
+    s->line_len = 0;
+    s->synth_pos = 0;
+    detector_init(&s->det);
+    streams.push_back(std::move(s));
+    return streams.back().get();
+}
+
+/*
+Move parsed samples from pending input into the ring until either runs
+out. Returns true if pending is empty afterwards. At EOF the reader
+appends a newline, so a last line without one is still parsed.
+*/
+static bool drain_pending(Stream *s)
+{
+    std::lock_guard<std::mutex> g(s->lock);
+    int used = 0;
+
+    while (used < s->pending_len && s->ring_count < RING_SAMPLES) {
+        char c = s->pending[used++];
+        if (c != '\n') {
+            if (s->line_len < MAX_LINE - 1) s->line[s->line_len++] = c;
+            continue;
+        }
+        s->line[s->line_len] = '\0';
+        s->line_len = 0;
+
+        Sample smp;
+        if (sscanf(s->line, "%f,%f,%f,%f,%f,%f",
+                   &smp.accel.ax, &smp.accel.ay, &smp.accel.az,
+                   &smp.gyro.gx, &smp.gyro.gy, &smp.gyro.gz) != 6) {
+            continue;   // header or malformed line
+        }
+        s->ring[(s->ring_head + s->ring_count) % RING_SAMPLES] = smp;
+        s->ring_count++;
+    }
+
+    memmove(s->pending, s->pending + used, s->pending_len - used);
+    s->pending_len -= used;
+
+    if (s->ring_count > 0) {
+        schedule_locked(s);
+    } else if (s->eof && s->pending_len == 0 && !s->scheduled) {
+        s->done = true;
+    }
+    return s->pending_len == 0;
+}
+
+static int open_listener(const char *path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+Free finished streams. A done stream is neither queued nor held by a
+worker and its input is closed, so nothing else refers to it.
+*/
+static void remove_done(void)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < streams.size(); i++) {
+        Stream *s = streams[i].get();
+        bool done;
+        {
+            std::lock_guard<std::mutex> g(s->lock);
+            done = s->done;
+        }
+        if (!done) {
+            streams[kept++] = std::move(streams[i]);
+            continue;
+        }
+        if (s->fd >= 0) {
+            fprintf(stderr, "[GW] %s finished: %ld samples, %ld windows\n",
+                    s->name.c_str(), s->samples, s->windows);
+        }
+        finished_streams++;
+        finished_samples += s->samples;
+        finished_windows += s->windows;
+        streams[i].reset();
+    }
+    streams.resize(kept);
+}
+
+// reader loop: poll every source that has room, until all streams finished
+static void read_loop(int listen_fd, int max_streams)
+{
+    std::vector<struct pollfd> fds;
+    std::vector<Stream *> owners;
+
+    while (true) {
+        remove_done();
+        if (listen_fd < 0 && streams.empty()) {
+            break;
+        }
+        fds.clear();
+        owners.clear();
+
+        if (listen_fd >= 0 && (int)streams.size() < max_streams) {
+            fds.push_back({ listen_fd, POLLIN, 0 });
+            owners.push_back(NULL);
+        }
+        for (const std::unique_ptr<Stream> &s : streams) {
+            // only read when earlier input has fully reached the ring
+            if (drain_pending(s.get()) && !s->eof) {
+                fds.push_back({ s->fd, POLLIN, 0 });
+                owners.push_back(s.get());
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), 10) <= 0) {
+            continue;
+        }
+
+        for (size_t i = 0; i < fds.size(); i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+
+            if (owners[i] == NULL) {
+                int fd = accept(listen_fd, NULL, NULL);
+                if (fd >= 0) {
+                    char name[32];
+                    snprintf(name, sizeof(name), "client%d", next_stream_id);
+                    add_stream(fd, name);
+                    fprintf(stderr, "[GW] %s connected\n", name);
+                }
+                continue;
+            }
+
+            Stream *s = owners[i];
+            ssize_t n = read(s->fd, s->pending, PENDING_BYTES);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                {
+                    std::lock_guard<std::mutex> g(s->lock);
+                    s->eof = true;
+                    close(s->fd);
+                    // terminate a last line that has no newline
+                    if (s->line_len > 0) {
+                        s->pending[0] = '\n';
+                        s->pending_len = 1;
+                    }
+                }
+                drain_pending(s);
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> g(s->lock);
+                s->pending_len = (int)n;
+            }
+            drain_pending(s);
+        }
+    }
+}
+
+// ---- main ---------------------------------------------------------------
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: gateway [-j threads] [-q] trace.csv...\n"
+            "       gateway [-j threads] [-q] --listen socket_path [--max-streams N]\n"
+            "       gateway [-j threads] --load N [--seconds S]\n");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    const char *listen_path = NULL;
+    int max_streams = 64;
+    int load = 0;
+    double seconds = 5.0;
+    std::vector<const char *> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+            listen_path = argv[++i];
+        } else if (strcmp(argv[i], "--max-streams") == 0 && i + 1 < argc) {
+            max_streams = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            load = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (threads == 0) threads = 1;
+    if (load == 0 && files.empty() && listen_path == NULL) {
+        usage();
+        return 1;
+    }
+
+    fprintf(stderr, "[GW] %u workers, %zu bytes per stream\n", threads, sizeof(Stream));
+
+    std::vector<std::thread> pool;
+    for (unsigned w = 0; w < threads; w++) {
+        pool.emplace_back(worker);
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    if (load > 0) {
+        quiet = true;
+        synth_init();
+        for (int i = 0; i < load; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "synth%d", i);
+            Stream *s = add_stream(-1, name);
+            // spread streams over the table so windows do not line up
+            s->synth_pos = (int)(((long)i * 997) % SYNTH_SAMPLES);
+            std::lock_guard<std::mutex> g(s->lock);
+            schedule_locked(s);
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    } else {
+        for (const char *path : files) {
+            int fd = open(path, O_RDONLY);
+            if (fd < 0) {
+                perror(path);
+                continue;
+            }
+            add_stream(fd, path);
+        }
+        int listen_fd = listen_path ? open_listener(listen_path) : -1;
+        if (listen_path && listen_fd < 0) {
+            return 1;
+        }
+        read_loop(listen_fd, max_streams);
+    }
+
+    {
+        std::lock_guard<std::mutex> g(queue_lock);
+        stopping = true;
+        queue_cv.notify_all();
+    }
+    for (std::thread &t : pool) t.join();
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    long samples = finished_samples;
+    long windows = finished_windows;
+    for (const std::unique_ptr<Stream> &s : streams) {
+        samples += s->samples;
+        windows += s->windows;
+    }
+
+    double rate = (sec > 0) ? samples / sec : 0.0;
+    fprintf(stderr, "[GW] %ld streams, %ld windows, %ld samples in %.2f s: %.0f samples/s\n",
+            finished_streams + (long)streams.size(), windows, samples, sec, rate);
+    fprintf(stderr, "[GW] capacity: %.0f real-time %d Hz streams per core\n",
+            rate / SAMPLE_RATE / threads, SAMPLE_RATE);
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+Detection latency benchmark on synthetic IMU traces (tools/synth_imu.h).
+
+Every scenario starts with rest of random length (so onsets do not line up
+with windows) followed by a labeled event. Each trial feeds the trace
+sample by sample through the same Detector as main.cpp and reports:
+
+  - detection latency: onset of the event -> end of the first window that
+    raises the matching flag (tremor, dyskinesia or FOG)
+  - false-positive rate: flagged windows among windows that lie completely
+    inside segments where that flag is not expected
+  - CPU per window: host time of detector_push() per analysed window
+
+With --max-latency / --max-fp / --min-detect the run becomes a gate and
+exits with 1 when a limit is exceeded.
+
+Build like batch_analyzer:
+    g++ -O2 -std=c++17 -DHOST_BUILD -Iinclude -Itools -Ilib/CMSIS-DSP-main/Include \
+        tools/latency_bench.cpp tools/synth_imu.cpp src/detector.cpp \
+        src/fft_analysis.cpp src/filter.cpp src/classifier.cpp src/scratch_arena.cpp \
+        src/orientation.cpp src/zoom_fft.cpp <CMSIS-DSP sources> -o latency_bench
+
+    ./latency_bench -n 20
+    ./latency_bench -n 20 --max-latency 9 --max-fp 0.10
+    ./latency_bench --dump fog fog.csv       # trace for batch_analyzer / gateway
+
+Gate limits: the full-band FFT (no window, band magnitudes summed) leaks
+about 10% of the 0.9 Hz arm swing into the tremor band while walking and
+of a 3 Hz tremor into the dyskinesia band, which costs it ~7.6% tremor
+and ~4.5% dyskinesia false positives. Built with -DUSE_ZOOM_FFT=1 (Hann
+window) the same run has none and passes --max-fp 0.05.
+*/
+#include "detector.h"
+#include "synth_imu.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SEGS  4
+
+struct Scenario {
+    const char *name;
+    SynthSegment segs[MAX_SEGS];
+    int n_segs;
+    int event_seg;          // segment whose onset is measured, -1 for none
+};
+
+/*
+First segment is rest, its length gets 0..WINDOW_SEC s of jitter per trial.
+Event frequencies sit in the classifier bands (CLS_TREM_*, CLS_DYSK_*):
+the detector sees motion at its own frequency, so a 5 Hz oscillation is
+dyskinesia-band energy, not tremor.
+*/
+static const Scenario scenarios[] = {
+    { "tremor_2.5hz", { { SYNTH_REST, 10, 0, 0 }, { SYNTH_TREMOR, 30, 2.5f, 0.15f } }, 2, 1 },
+    { "tremor_3hz",   { { SYNTH_REST, 10, 0, 0 }, { SYNTH_TREMOR, 30, 3.0f, 0.15f } }, 2, 1 },
+    { "tremor_weak",  { { SYNTH_REST, 10, 0, 0 }, { SYNTH_TREMOR, 30, 2.5f, 0.03f } }, 2, 1 },
+    { "dyskinesia",   { { SYNTH_REST, 10, 0, 0 }, { SYNTH_DYSKINESIA, 30, 4.5f, 0.3f } }, 2, 1 },
+    { "fog",          { { SYNTH_REST, 10, 0, 0 }, { SYNTH_WALK, 20, 1.8f, 0.3f },
+                        { SYNTH_FREEZE, 15, 0, 0.05f } }, 3, 2 },
+    { "rest",         { { SYNTH_REST, 60, 0, 0 } }, 1, -1 },
+};
+#define N_SCENARIOS (int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+// flags a segment kind is expected to raise
+static bool expects(SynthKind kind, int flag)
+{
+    switch (flag) {
+    case 0: return kind == SYNTH_TREMOR;
+    case 1: return kind == SYNTH_DYSKINESIA;
+    case 2: return kind == SYNTH_FREEZE;
+    }
+    return false;
+}
+
+static int result_flag(const WindowResult *r, int flag)
+{
+    switch (flag) {
+    case 0: return r->tremor_flag;
+    case 1: return r->dyskinesia_flag;
+    case 2: return r->fog_flag;
+    }
+    return 0;
+}
+
+static const char *flag_names[3] = { "tremor", "dyskinesia", "fog" };
+
+struct Stats {
+    int trials;
+    int detected;
+    double latency_sum;
+    double latency_max;
+    long neg_windows[3];
+    long fp_windows[3];
+};
+
+static const SynthConfig base_cfg = { 1, 0.004f, 0.3f, 15.0f };
+
+static void make_trial(const Scenario *sc, int trial, SynthSegment *segs, SynthConfig *cfg)
+{
+    *cfg = base_cfg;
+    cfg->seed = 0x9E3779B9u * (uint32_t)(trial + 1) + (uint32_t)(sc - scenarios);
+
+    memcpy(segs, sc->segs, sizeof(sc->segs));
+    uint32_t r = cfg->seed;
+    r ^= r << 13; r ^= r >> 17; r ^= r << 5;
+    segs[0].duration_s += WINDOW_SEC * (float)(r % 1000) / 1000.0f;
+}
+
+static void run_trial(const Scenario *sc, int trial, Stats *st, double *cpu_sec, long *windows)
+{
+    SynthSegment segs[MAX_SEGS];
+    SynthConfig cfg;
+    SynthGen gen;
+    Detector det;
+    AccelData accel;
+    GyroData gyro;
+    SynthKind label;
+    WindowResult r;
+
+    make_trial(sc, trial, segs, &cfg);
+    synth_init(&gen, &cfg, segs, sc->n_segs);
+    detector_init(&det);
+
+    // label of every sample in the current window, to check window purity
+    SynthKind win_label[WINDOW_SAMPLES];
+    int win_fill = 0;
+
+    long onset = (sc->event_seg >= 0) ? synth_onset(&gen, sc->event_seg) : -1;
+    long event_end = (sc->event_seg >= 0) ? synth_onset(&gen, sc->event_seg + 1) : -1;
+    bool found = false;
+
+    st->trials++;
+
+    while (synth_next(&gen, &accel, &gyro, &label)) {
+        win_label[win_fill++] = label;
+
+        auto t0 = std::chrono::steady_clock::now();
+        bool done = detector_push(&det, accel, gyro, &r);
+        *cpu_sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (!done) {
+            continue;
+        }
+
+        long end = gen.sample;          // window covers [end - WINDOW_SAMPLES, end)
+        (*windows)++;
+        win_fill = 0;
+
+        bool pure = true;
+        for (int i = 1; i < WINDOW_SAMPLES; i++) {
+            if (win_label[i] != win_label[0]) pure = false;
+        }
+        for (int f = 0; f < 3 && pure; f++) {
+            if (!expects(win_label[0], f)) {
+                st->neg_windows[f]++;
+                if (result_flag(&r, f)) st->fp_windows[f]++;
+            }
+        }
+
+        // one window of grace after the event ends
+        if (!found && onset >= 0 && end > onset && end <= event_end + WINDOW_SAMPLES) {
+            SynthKind kind = segs[sc->event_seg].kind;
+            for (int f = 0; f < 3; f++) {
+                if (expects(kind, f) && result_flag(&r, f)) {
+                    double latency = (double)(end - onset) / SAMPLE_RATE;
+                    st->detected++;
+                    st->latency_sum += latency;
+                    if (latency > st->latency_max) st->latency_max = latency;
+                    found = true;
+                }
+            }
+        }
+    }
+}
+
+static int dump(const char *name, const char *path)
+{
+    for (int s = 0; s < N_SCENARIOS; s++) {
+        if (strcmp(scenarios[s].name, name) != 0) continue;
+
+        SynthSegment segs[MAX_SEGS];
+        SynthConfig cfg;
+        SynthGen gen;
+        AccelData a;
+        GyroData g;
+        SynthKind label;
+
+        FILE *f = fopen(path, "w");
+        if (f == NULL) {
+            perror(path);
+            return 1;
+        }
+        make_trial(&scenarios[s], 0, segs, &cfg);
+        synth_init(&gen, &cfg, segs, scenarios[s].n_segs);
+        fprintf(f, "ax,ay,az,gx,gy,gz,label\n");
+        while (synth_next(&gen, &a, &g, &label)) {
+            fprintf(f, "%.5f,%.5f,%.5f,%.3f,%.3f,%.3f,%s\n",
+                    a.ax, a.ay, a.az, g.gx, g.gy, g.gz, synth_kind_name(label));
+        }
+        fclose(f);
+        return 0;
+    }
+    fprintf(stderr, "unknown scenario %s\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int trials = 10;
+    double max_latency = -1.0;
+    double max_fp = -1.0;
+    double min_detect = -1.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            trials = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-latency") == 0 && i + 1 < argc) {
+            max_latency = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-fp") == 0 && i + 1 < argc) {
+            max_fp = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--min-detect") == 0 && i + 1 < argc) {
+            min_detect = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--dump") == 0 && i + 2 < argc) {
+            return dump(argv[i + 1], argv[i + 2]);
+        } else {
+            fprintf(stderr, "usage: latency_bench [-n trials] [--max-latency s] [--max-fp rate]"
+                            " [--min-detect rate] | --dump scenario out.csv\n");
+            return 1;
+        }
+    }
+
+    Stats total;
+    memset(&total, 0, sizeof(total));
+    double cpu_sec = 0.0;
+    long windows = 0;
+    bool failed = false;
+
+    printf("%-12s %6s %9s %9s %9s\n", "scenario", "trials", "detected", "lat_mean", "lat_max");
+    for (int s = 0; s < N_SCENARIOS; s++) {
+        Stats st;
+        memset(&st, 0, sizeof(st));
+        for (int t = 0; t < trials; t++) {
+            run_trial(&scenarios[s], t, &st, &cpu_sec, &windows);
+        }
+
+        for (int f = 0; f < 3; f++) {
+            total.neg_windows[f] += st.neg_windows[f];
+            total.fp_windows[f] += st.fp_windows[f];
+        }
+
+        if (scenarios[s].event_seg < 0) {
+            printf("%-12s %6d %9s %9s %9s\n", scenarios[s].name, st.trials, "-", "-", "-");
+            continue;
+        }
+
+        double rate = (double)st.detected / st.trials;
+        double mean = st.detected ? st.latency_sum / st.detected : 0.0;
+        printf("%-12s %6d %8.0f%% %8.2fs %8.2fs\n", scenarios[s].name, st.trials,
+               100.0 * rate, mean, st.latency_max);
+
+        if (min_detect >= 0 && rate < min_detect) failed = true;
+        if (max_latency >= 0 && st.detected && st.latency_max > max_latency) failed = true;
+    }
+
+    printf("\nfalse positives (windows fully outside the matching event):\n");
+    for (int f = 0; f < 3; f++) {
+        double rate = total.neg_windows[f] ? (double)total.fp_windows[f] / total.neg_windows[f] : 0.0;
+        printf("  %-10s %5ld / %-6ld %6.2f%%\n", flag_names[f],
+               total.fp_windows[f], total.neg_windows[f], 100.0 * rate);
+        if (max_fp >= 0 && rate > max_fp) failed = true;
+    }
+
+    printf("\nCPU: %ld windows, %.1f us per window (%.1f ns per sample)\n",
+           windows, windows ? 1e6 * cpu_sec / windows : 0.0,
+           windows ? 1e9 * cpu_sec / (windows * (double)WINDOW_SAMPLES) : 0.0);
+
+    if (failed) {
+        printf("\nGATE FAILED\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "synth_imu.h"
+#include "fft_analysis.h"
+#include <math.h>
+
+#define TWO_PI 6.28318530718f
+
+static const char *kind_names[SYNTH_KINDS] = {
+    "rest", "tremor", "dyskinesia", "walk", "freeze"
+};
+
+const char *synth_kind_name(SynthKind kind)
+{
+    return (kind >= 0 && kind < SYNTH_KINDS) ? kind_names[kind] : "?";
+}
+
+// xorshift32, uniform in [0, 1)
+static float rand_uniform(uint32_t *s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *s = x;
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+// standard normal, Box-Muller
+static float rand_normal(uint32_t *s)
+{
+    float u1 = rand_uniform(s);
+    float u2 = rand_uniform(s);
+    if (u1 < 1e-7f) u1 = 1e-7f;
+    return sqrtf(-2.0f * logf(u1)) * cosf(TWO_PI * u2);
+}
+
+// kept close together so a 4-5 Hz centre puts no tone into the 2-3 Hz tremor band
+static const float dysk_tones[3] = { 0.9f, 1.0f, 1.09f };
+
+static long seg_samples(const SynthSegment *seg)
+{
+    return (long)(seg->duration_s * SAMPLE_RATE + 0.5f);
+}
+
+static void enter_segment(SynthGen *g, int seg)
+{
+    g->seg = seg;
+    g->seg_start = g->sample;
+    for (int i = 0; i < 3; i++) {
+        g->phase[i] = TWO_PI * rand_uniform(&g->rng);
+    }
+}
+
+void synth_init(SynthGen *g, const SynthConfig *cfg, const SynthSegment *segs, int n_segs)
+{
+    g->cfg = *cfg;
+    g->segs = segs;
+    g->n_segs = n_segs;
+    g->sample = 0;
+    g->rng = cfg->seed ? cfg->seed : 1;
+
+    float tilt = cfg->tilt_deg * (TWO_PI / 360.0f);
+    g->gx = sinf(tilt);
+    g->gz = cosf(tilt);
+
+    enter_segment(g, 0);
+}
+
+long synth_onset(const SynthGen *g, int seg)
+{
+    long start = 0;
+    for (int i = 0; i < seg && i < g->n_segs; i++) {
+        start += seg_samples(&g->segs[i]);
+    }
+    return start;
+}
+
+long synth_total(const SynthGen *g)
+{
+    return synth_onset(g, g->n_segs);
+}
+
+/*
+Produce the next sample. Accel in g, gyro in dps, label is the kind of
+the segment the sample belongs to. Returns false after the last segment.
+*/
+bool synth_next(SynthGen *g, AccelData *accel, GyroData *gyro, SynthKind *label)
+{
+    while (g->seg < g->n_segs && g->sample - g->seg_start >= seg_samples(&g->segs[g->seg])) {
+        if (g->seg + 1 >= g->n_segs) {
+            return false;
+        }
+        enter_segment(g, g->seg + 1);
+    }
+    if (g->seg >= g->n_segs) {
+        return false;
+    }
+
+    const SynthSegment *seg = &g->segs[g->seg];
+    float t = (float)(g->sample - g->seg_start) / SAMPLE_RATE;
+    float w = TWO_PI * seg->freq_hz;
+
+    // linear accel (g) and angular rate (dps) of the motion model
+    float lx = 0.0f, ly = 0.0f, lz = 0.0f;
+    float rx = 0.0f, ry = 0.0f, rz = 0.0f;
+
+    switch (seg->kind) {
+    case SYNTH_TREMOR:
+        lx = seg->amp * sinf(w * t + g->phase[0]);
+        ly = 0.3f * seg->amp * sinf(w * t + g->phase[1]);
+        ry = 200.0f * seg->amp * cosf(w * t + g->phase[0]);
+        break;
+    case SYNTH_DYSKINESIA:
+        // three incommensurate tones within +-10% of freq_hz, slow amplitude drift
+        for (int i = 0; i < 3; i++) {
+            float f = seg->freq_hz * dysk_tones[i];
+            float a = seg->amp * (1.0f - 0.25f * i) * (0.7f + 0.3f * sinf(0.5f * t + g->phase[i]));
+            lx += a * sinf(TWO_PI * f * t + g->phase[i]);
+            lz += 0.5f * a * cosf(TWO_PI * f * t + g->phase[(i + 1) % 3]);
+            rz += 150.0f * a * cosf(TWO_PI * f * t + g->phase[i]);
+        }
+        break;
+    case SYNTH_WALK:
+        // heel strikes: fundamental at cadence plus second harmonic
+        lz = seg->amp * sinf(w * t + g->phase[0]) +
+             0.4f * seg->amp * sinf(2.0f * w * t + g->phase[1]);
+        lx = 0.3f * seg->amp * sinf(0.5f * w * t + g->phase[2]);
+        rx = 120.0f * seg->amp * cosf(0.5f * w * t + g->phase[2]);
+        break;
+    case SYNTH_FREEZE:
+        // trembling in place, 3-8 Hz knee trembling at small amplitude
+        lz = 0.1f * seg->amp * sinf(TWO_PI * 6.0f * t + g->phase[0]);
+        break;
+    case SYNTH_REST:
+    default:
+        break;
+    }
+
+    accel->ax = g->gx + lx + g->cfg.accel_noise_g * rand_normal(&g->rng);
+    accel->ay =         ly + g->cfg.accel_noise_g * rand_normal(&g->rng);
+    accel->az = g->gz + lz + g->cfg.accel_noise_g * rand_normal(&g->rng);
+    gyro->gx = rx + g->cfg.gyro_noise_dps * rand_normal(&g->rng);
+    gyro->gy = ry + g->cfg.gyro_noise_dps * rand_normal(&g->rng);
+    gyro->gz = rz + g->cfg.gyro_noise_dps * rand_normal(&g->rng);
+
+    *label = seg->kind;
+    g->sample++;
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include "imu_driver.h"
+
+/*
+Deterministic synthetic six-axis IMU signal for host benchmarks.
+
+A scenario is a list of back-to-back segments (rest, tremor, dyskinesia,
+walking, freeze). Every sample carries gravity (1 g, tilted by a fixed
+posture), white sensor noise and the motion model of its segment. The
+same seed always gives the same trace, and segment start times are the
+ground-truth onsets.
+*/
+
+typedef enum {
+    SYNTH_REST = 0,
+    SYNTH_TREMOR,        // sinusoidal limb oscillation at freq_hz
+    SYNTH_DYSKINESIA,    // irregular three-tone movement, 0.9-1.09 x freq_hz
+    SYNTH_WALK,          // gait at freq_hz steps per second
+    SYNTH_FREEZE,        // freezing of gait: near still, small trembling
+    SYNTH_KINDS
+} SynthKind;
+
+typedef struct {
+    SynthKind kind;
+    float duration_s;
+    float freq_hz;       // tremor frequency, dyskinesia centre, cadence
+    float amp;           // main amplitude in g
+} SynthSegment;
+
+typedef struct {
+    uint32_t seed;
+    float accel_noise_g;     // white noise std dev
+    float gyro_noise_dps;
+    float tilt_deg;          // posture: gravity tilted about the y axis
+} SynthConfig;
+
+typedef struct {
+    SynthConfig cfg;
+    const SynthSegment *segs;
+    int n_segs;
+    int seg;                 // current segment
+    long sample;             // absolute sample index
+    long seg_start;          // sample index where seg started
+    uint32_t rng;
+    float gx, gz;            // gravity components (g)
+    float phase[3];          // random phases of the current segment
+} SynthGen;
+
+const char *synth_kind_name(SynthKind kind);
+void synth_init(SynthGen *g, const SynthConfig *cfg, const SynthSegment *segs, int n_segs);
+bool synth_next(SynthGen *g, AccelData *accel, GyroData *gyro, SynthKind *label);
+long synth_onset(const SynthGen *g, int seg);   // start sample of segment seg
+long synth_total(const SynthGen *g);
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""
+Train the window classifier and export it as include/classifier_model.h.
+
+Input is a CSV of labeled windows, one row per analysis window:
+
+    trem_ratio,dysk_ratio,step_ratio,variance,tremor,dyskinesia,walking
+
+Ratios are band energy / total energy (0.5-10 Hz), variance is the window
+variance of the fused signal, labels are 0/1. Features are quantized the
+same way as classifier_quantize() on the device, then one complete binary
+tree of depth CLS_TREE_DEPTH is grown per label (greedy Gini splits).
+
+    python3 tools/train_classifier.py windows.csv
+    python3 tools/train_classifier.py --rules        # fixed-threshold model
+
+The accuracy of the trained trees and of the threshold rules (as
+exported by --rules, on the quantized features) is printed for
+comparison.
+"""
+import argparse
+import csv
+import math
+import sys
+
+DEPTH = 3
+NODES = (1 << DEPTH) - 1
+LEAVES = 1 << DEPTH
+FEATURES = ["trem_ratio", "dysk_ratio", "step_ratio", "variance"]
+LABELS = ["tremor", "dyskinesia", "walking"]
+RATIO_SCALE = 100.0
+VAR_SCALE = 1000.0
+
+# old fixed rules: (feature index, threshold on the raw ratio)
+RULES = [(0, 0.10), (1, 0.10), (2, 0.20)]
+
+PAD_FEATURE = 0
+PAD_THRESHOLD = 127  # never taken, always goes left
+
+
+def quantize(x, scale):
+    q = x * scale
+    if q <= 0.0:
+        return 0
+    if q >= 127.0:
+        return 127
+    return int(q)
+
+
+def load(path):
+    rows = []
+    with open(path, newline="") as f:
+        for r in csv.DictReader(f):
+            x = [quantize(float(r["trem_ratio"]), RATIO_SCALE),
+                 quantize(float(r["dysk_ratio"]), RATIO_SCALE),
+                 quantize(float(r["step_ratio"]), RATIO_SCALE),
+                 quantize(float(r["variance"]), VAR_SCALE)]
+            y = [int(r[name]) for name in LABELS]
+            rows.append((x, y))
+    return rows
+
+
+def gini(pos, n):
+    if n == 0:
+        return 0.0
+    p = pos / n
+    return 2.0 * p * (1.0 - p)
+
+
+def best_split(samples):
+    n = len(samples)
+    pos = sum(y for _, y in samples)
+    best = None
+    best_score = gini(pos, n)
+    for f in range(len(FEATURES)):
+        for t in sorted({x[f] for x, _ in samples})[:-1]:
+            left = [y for x, y in samples if x[f] <= t]
+            nl, pl = len(left), sum(left)
+            nr, pr = n - nl, pos - pl
+            score = (nl * gini(pl, nl) + nr * gini(pr, nr)) / n
+            if score < best_score - 1e-9:
+                best_score, best = score, (f, t)
+    return best
+
+
+def majority(samples, default):
+    if not samples:
+        return default
+    pos = sum(y for _, y in samples)
+    return 1 if 2 * pos > len(samples) else 0
+
+
+def grow(samples):
+    feature = [PAD_FEATURE] * NODES
+    threshold = [PAD_THRESHOLD] * NODES
+    leaf = [0] * LEAVES
+
+    def build(node, subset, default):
+        if node >= NODES:
+            leaf[node - NODES] = majority(subset, default)
+            return
+        label = majority(subset, default)
+        split = best_split(subset) if subset else None
+        if split is None:
+            # padding node: every sample goes left, right leaf inherits label
+            build(2 * node + 1, subset, label)
+            build(2 * node + 2, [], label)
+            return
+        f, t = split
+        feature[node], threshold[node] = f, t
+        build(2 * node + 1, [s for s in subset if s[0][f] <= t], label)
+        build(2 * node + 2, [s for s in subset if s[0][f] > t], label)
+
+    build(0, samples, 0)
+    return feature, threshold, leaf
+
+
+def rule_threshold(thr, scale):
+    """
+    Integer threshold t with quantize(x) > t  <=>  x >= thr, for thr on the
+    quantization grid. quantize() truncates, so x >= 0.10 maps to q >= 10,
+    i.e. q > 9; using quantize(thr) itself would only fire from 0.11.
+    """
+    return int(math.ceil(thr * scale - 1e-6)) - 1
+
+
+def rule_tree(f, thr):
+    feature = [f] * NODES
+    threshold = [PAD_THRESHOLD] * NODES
+    threshold[0] = rule_threshold(thr, RATIO_SCALE)
+    leaf = [0] * LEAVES
+    # root right, then padding nodes go left twice
+    node = 2
+    for _ in range(DEPTH - 1):
+        node = 2 * node + 1
+    leaf[node - NODES] = 1
+    return feature, threshold, leaf
+
+
+def predict(tree, x):
+    feature, threshold, leaf = tree
+    node = 0
+    for _ in range(DEPTH):
+        node = 2 * node + 1 + (1 if x[feature[node]] > threshold[node] else 0)
+    return leaf[node - NODES]
+
+
+def export(trees, path, source, note=None):
+    def arr(v):
+        return "{ " + ", ".join(str(int(x)) for x in v) + " }"
+
+    out = ["#pragma once", '#include "classifier.h"', "",
+           "// Generated by tools/train_classifier.py " + source]
+    if note:
+        out.append("// " + note)
+    out += ["",
+           "static const ClsModel cls_default_model = {", "    {"]
+    for name, (feature, threshold, leaf) in zip(LABELS, trees):
+        out += ["        { // " + name,
+                "            " + arr(feature) + ",",
+                "            " + arr(threshold) + ",",
+                "            " + arr(leaf) + ",",
+                "        },"]
+    out += ["    }", "};", ""]
+    with open(path, "w") as f:
+        f.write("\n".join(out))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("csv", nargs="?", help="labeled windows")
+    ap.add_argument("--rules", action="store_true",
+                    help="export the fixed-threshold rules instead of training")
+    ap.add_argument("--out", default="include/classifier_model.h")
+    args = ap.parse_args()
+
+    if args.rules:
+        trees = [rule_tree(f, t) for f, t in RULES]
+        export(trees, args.out, "--rules",
+               "Reproduces the fixed ratio thresholds: trem >= 0.10, dysk >= 0.10, step >= 0.20")
+        print("wrote", args.out)
+        return 0
+
+    if not args.csv:
+        ap.error("need a CSV of labeled windows (or --rules)")
+
+    rows = load(args.csv)
+    if not rows:
+        print("no rows in", args.csv, file=sys.stderr)
+        return 1
+
+    trees = []
+    for k, name in enumerate(LABELS):
+        tree = grow([(x, y[k]) for x, y in rows])
+        trees.append(tree)
+        tree_acc = sum(predict(tree, x) == y[k] for x, y in rows) / len(rows)
+        # the rule model as shipped, on the same quantized features
+        rules = rule_tree(*RULES[k])
+        rule_acc = sum(predict(rules, x) == y[k] for x, y in rows) / len(rows)
+        print("%-11s tree %.3f  rules %.3f  (%d windows)" % (name, tree_acc, rule_acc, len(rows)))
+
+    export(trees, args.out, args.csv.split("/")[-1])
+    print("wrote", args.out)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
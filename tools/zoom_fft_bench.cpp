@@ -0,0 +1,214 @@
+/*
+Zoom FFT vs full-band FFT on synthetic analysis windows.
+
+Each trial is one WINDOW_SAMPLES window at SAMPLE_RATE: a tone of known
+frequency (0.6..9.8 Hz, random phase) on a DC offset with noise, i.e. what
+detector_fuse() hands to the spectrum. Both spectra are computed on the
+same window (both remove the window mean first):
+
+  - peak frequency error: plain peak bin and parabolic interpolation
+  - worst spurious peak: largest bin away from the tone's main lobe, which
+    shows DC leakage and the images folded back by the decimation
+  - cross-band leakage: share of CLS_TOTAL band energy that a tone inside
+    the tremor band puts into the dyskinesia band, and the reverse
+  - cost per window: host time, and DWT cycles when built for the target
+
+Host timings only mean something against the real CMSIS-DSP sources.
+
+Build like batch_analyzer:
+    g++ -O2 -std=c++17 -DHOST_BUILD -Iinclude -Ilib/CMSIS-DSP-main/Include \
+        tools/zoom_fft_bench.cpp src/zoom_fft.cpp src/fft_analysis.cpp \
+        src/classifier.cpp src/scratch_arena.cpp <CMSIS-DSP sources> -o zoom_fft_bench
+
+    ./zoom_fft_bench -n 2000
+*/
+#include "detector.h"
+#include "zoom_fft.h"
+#include "cycle_counter.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define F_MIN       0.6f
+#define F_MAX       9.8f
+#define TONE_AMP    0.1f
+#define DC_OFFSET   0.3f
+#define NOISE_AMP   0.01f
+#define SPUR_GUARD  0.7f        // Hz around the tone that belongs to its main lobe
+
+struct ErrStats {
+    double sum;
+    double max;
+    int n;
+};
+
+static void err_add(ErrStats *s, double err)
+{
+    err = fabs(err);
+    s->sum += err;
+    if (err > s->max) s->max = err;
+    s->n++;
+}
+
+static uint32_t rng(uint32_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+static float uniform(uint32_t *s)
+{
+    return (float)(rng(s) & 0xFFFFFF) / (float)0x1000000;
+}
+
+static void make_window(float32_t *w, float f, uint32_t *seed)
+{
+    float phase = 2.0f * PI * uniform(seed);
+    for (int i = 0; i < WINDOW_SAMPLES; i++) {
+        float t = (float)i / SAMPLE_RATE;
+        w[i] = DC_OFFSET + TONE_AMP * sinf(2.0f * PI * f * t + phase)
+             + NOISE_AMP * (uniform(seed) - 0.5f);
+    }
+}
+
+// frequency of the largest bin in range, no interpolation
+static float peak_bin(const float32_t *mag, int start, int end, float f0, float bin_hz)
+{
+    int k = start;
+    for (int i = start + 1; i <= end; i++) {
+        if (mag[i] > mag[k]) k = i;
+    }
+    return f0 + k * bin_hz;
+}
+
+// largest bin farther than SPUR_GUARD from the tone, relative to the tone peak (dB)
+static float spur_db(const float32_t *mag, int start, int end, float f0, float bin_hz,
+                     float f, float tone_amp)
+{
+    float spur = 0.0f;
+    for (int i = start; i <= end; i++) {
+        if (fabsf(f0 + i * bin_hz - f) > SPUR_GUARD && mag[i] > spur) spur = mag[i];
+    }
+    return 20.0f * log10f((spur + 1e-12f) / tone_amp);
+}
+
+enum { FULL, ZOOM, N_METHODS };
+static const char *method_names[N_METHODS] = { "full", "zoom" };
+
+int main(int argc, char **argv)
+{
+    int trials = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            trials = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: zoom_fft_bench [-n trials]\n");
+            return 1;
+        }
+    }
+
+    static FftContext full;
+    static ZoomFftContext zoom;
+    float32_t window[WINDOW_SAMPLES];
+    uint32_t seed = 0x12345678u;
+
+    const float full_hz = (float)SAMPLE_RATE / FFT_SIZE;
+    const int full_lo = (int)(CLS_TOTAL_LOW / full_hz), full_hi = (int)(CLS_TOTAL_HIGH / full_hz);
+    const int zoom_lo = (int)((CLS_TOTAL_LOW - ZOOM_F_START) / ZOOM_BIN_HZ);
+    const int zoom_hi = (int)((CLS_TOTAL_HIGH - ZOOM_F_START) / ZOOM_BIN_HZ);
+
+    ErrStats bin_err[N_METHODS] = {}, interp_err[N_METHODS] = {};
+    double leak[N_METHODS][2] = {};
+    int leak_n[2] = { 0, 0 };
+    float spur_max[N_METHODS] = { -200.0f, -200.0f };
+    double sec[N_METHODS] = {};
+    uint64_t cycles[N_METHODS] = {};
+
+    cycle_counter_init();
+
+    for (int t = 0; t < trials; t++) {
+        float f = F_MIN + (F_MAX - F_MIN) * uniform(&seed);
+        make_window(window, f, &seed);
+
+        for (int m = 0; m < N_METHODS; m++) {
+            auto t0 = std::chrono::steady_clock::now();
+            uint32_t c0 = cycle_counter_read();
+            if (m == FULL) {
+                fft_compute(&full, window, WINDOW_SAMPLES);
+            } else {
+                zoom_fft_compute(&zoom, window, WINDOW_SAMPLES);
+            }
+            cycles[m] += cycle_counter_read() - c0;
+            sec[m] += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+
+        BandEnergy e[N_METHODS];
+        for (int m = 0; m < N_METHODS; m++) {
+            const float32_t *mag = (m == ZOOM) ? zoom.mag : full.mag;
+            float f0 = (m == ZOOM) ? ZOOM_F_START : 0.0f;
+            float hz = (m == ZOOM) ? ZOOM_BIN_HZ : full_hz;
+            int lo = (m == ZOOM) ? zoom_lo : full_lo;
+            int hi = (m == ZOOM) ? zoom_hi : full_hi;
+
+            SpectralPeak p = (m == ZOOM) ? zoom_fft_peak(&zoom, CLS_TOTAL_LOW, CLS_TOTAL_HIGH)
+                                         : fft_get_peak(&full, CLS_TOTAL_LOW, CLS_TOTAL_HIGH);
+            err_add(&bin_err[m], peak_bin(mag, lo, hi, f0, hz) - f);
+            err_add(&interp_err[m], p.freq - f);
+
+            float spur = spur_db(mag, lo, hi, f0, hz, f, p.amp);
+            if (spur > spur_max[m]) spur_max[m] = spur;
+
+            if (m == ZOOM) {
+                classifier_band_energy_zoom(&zoom, &e[m]);
+            } else {
+                classifier_band_energy(&full, &e[m]);
+            }
+        }
+
+        // tone well inside one band: how much of the total lands in the other
+        int side = -1;
+        if (f >= CLS_TREM_LOW + 0.25f && f <= CLS_TREM_HIGH - 0.25f) side = 0;
+        if (f >= CLS_DYSK_LOW + 0.25f && f <= CLS_DYSK_HIGH - 0.25f) side = 1;
+        if (side >= 0) {
+            for (int m = 0; m < N_METHODS; m++) {
+                leak[m][side] += (side == 0 ? e[m].dysk : e[m].trem) / e[m].total;
+            }
+            leak_n[side]++;
+        }
+    }
+
+    printf("%d windows of %d samples at %d Hz, tones %.1f..%.1f Hz\n\n",
+           trials, WINDOW_SAMPLES, SAMPLE_RATE, F_MIN, F_MAX);
+
+    printf("%-24s", "");
+    for (int m = 0; m < N_METHODS; m++) printf(" %10s", method_names[m]);
+    printf("\n%-24s %7d pt %7d pt\n", "FFT size", FFT_SIZE, ZOOM_FFT_SIZE);
+    printf("%-24s %7.3f Hz %7.3f Hz\n", "bin width", full_hz, ZOOM_BIN_HZ);
+
+    printf("%-24s", "peak bin err mean");
+    for (int m = 0; m < N_METHODS; m++) printf(" %7.3f Hz", bin_err[m].sum / bin_err[m].n);
+    printf("\n%-24s", "peak bin err max");
+    for (int m = 0; m < N_METHODS; m++) printf(" %7.3f Hz", bin_err[m].max);
+    printf("\n%-24s", "interpolated err mean");
+    for (int m = 0; m < N_METHODS; m++) printf(" %7.3f Hz", interp_err[m].sum / interp_err[m].n);
+    printf("\n%-24s", "interpolated err max");
+    for (int m = 0; m < N_METHODS; m++) printf(" %7.3f Hz", interp_err[m].max);
+    printf("\n%-24s", "worst spurious peak");
+    for (int m = 0; m < N_METHODS; m++) printf(" %7.1f dB", spur_max[m]);
+    for (int side = 0; side < 2; side++) {
+        if (!leak_n[side]) continue;
+        printf("\n%-24s", side == 0 ? "tremor -> dysk band" : "dysk -> tremor band");
+        for (int m = 0; m < N_METHODS; m++) printf(" %8.1f %%", 100.0 * leak[m][side] / leak_n[side]);
+    }
+    printf("\n%-24s", "time per window");
+    for (int m = 0; m < N_METHODS; m++) printf(" %7.2f us", 1e6 * sec[m] / trials);
+    printf("\n%-24s", "cycles per window");
+    for (int m = 0; m < N_METHODS; m++) printf(" %10lu", (unsigned long)(cycles[m] / trials));
+    printf("\n");
+    return 0;
+}